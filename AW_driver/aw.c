@@ -5,10 +5,49 @@
  *
  * revision history:
  *  v1.0 Creation (16/08/2024)
+ *  v1.1 Fix the arguments of setKAWL/setKAWR in awUpdateServo (16/10/2026)
+ *  v1.2 AW update in the main loop (refer to servoTask) (16/10/2026)
+ *  v1.3 Scan and debounce of the KAW switches (16/10/2026)
+ *  v1.4 AW status register as bit masks (one bit per AW) (16/10/2026)
+ *  v1.5 Only the first 8 servos are AW (SERVO_COUNT) (16/10/2026)
+ *  v1.6 Motion profile per AW (endpoints, sweep time, ease) (16/10/2026)
+ *  v1.7 AW status in the data EEPROM (warm start) (16/10/2026)
+ *  v1.8 CRC-8 of the AW status records (16/10/2026)
+ *  v1.9 Profiles at compile time (AW_PROFILES), constant ease table (16/10/2026)
+ *  v1.10 Unused getAwMoving removed (16/10/2026)
 */
 
 #include "aw.h"
 
+// <editor-fold defaultstate="collapsed" desc="tables">
+
+// motion profiles of the AW (refer to AW_PROFILES)
+const awProfileConfig_t awProfileConfig[8] = AW_PROFILES;
+
+// ease-in/ease-out table (smoothstep 3x² - 2x³, 0 - 255), a constant table
+// in the program memory (no RAM and no computation at init), the values are
+// (x * x * (3 * 255 - 2 * x)) / (255 * 255) for x = 0 - 255
+const uint8_t awEase[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   2,   2,
+      2,   3,   3,   4,   4,   4,   5,   5,   6,   6,   7,   7,   8,   9,   9,  10,
+     11,  11,  12,  13,  13,  14,  15,  16,  16,  17,  18,  19,  20,  21,  21,  22,
+     23,  24,  25,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,  36,  37,  39,
+     40,  41,  42,  43,  44,  45,  47,  48,  49,  50,  51,  53,  54,  55,  56,  58,
+     59,  60,  62,  63,  64,  66,  67,  68,  70,  71,  72,  74,  75,  77,  78,  79,
+     81,  82,  84,  85,  86,  88,  89,  91,  92,  94,  95,  97,  98,  99, 101, 102,
+    104, 105, 107, 108, 110, 111, 113, 114, 116, 117, 119, 120, 122, 123, 125, 126,
+    128, 129, 131, 132, 134, 135, 137, 138, 140, 141, 143, 144, 146, 147, 149, 150,
+    152, 153, 155, 156, 157, 159, 160, 162, 163, 165, 166, 168, 169, 170, 172, 173,
+    175, 176, 177, 179, 180, 182, 183, 184, 186, 187, 188, 190, 191, 192, 194, 195,
+    196, 198, 199, 200, 201, 203, 204, 205, 206, 207, 209, 210, 211, 212, 213, 214,
+    215, 217, 218, 219, 220, 221, 222, 223, 224, 225, 226, 227, 228, 229, 230, 231,
+    232, 233, 233, 234, 235, 236, 237, 238, 238, 239, 240, 241, 241, 242, 243, 243,
+    244, 245, 245, 246, 247, 247, 248, 248, 249, 249, 250, 250, 250, 251, 251, 252,
+    252, 252, 253, 253, 253, 253, 254, 254, 254, 254, 254, 254, 254, 254, 254, 255
+};
+
+// </editor-fold>
+
 // <editor-fold defaultstate="collapsed" desc="initialisation">
 
 /**
@@ -23,6 +62,17 @@ void awInit(awCallback_t fptr)
     // init of the AW ports B and C (= KAWL/KAWR switches)
     awInitPortBC();
 
+    // init of the motion profiles (AW_PROFILES), all AW in the middle
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        const awProfileConfig_t* config = &awProfileConfig[i];
+        awSetProfile(i, config->left, config->right, config->sweep,
+                config->ease);
+        awPhase[i] = AW_PHASE_MIDDLE;
+    }
+    // restore the last AW status (without reports)
+    awRestore();
+
     // initialisation of the servo variables
     servoInit(&awUpdate);    
 }
@@ -58,6 +108,35 @@ void awInitPortBC()
     TRISCbits.TRISC5 = false;
     LATCbits.LATC4 = true;
     LATCbits.LATC5 = true;
+
+    // all switches are open, the vertical counters are reset
+    awSwitchKAWL.state = 0x00;
+    awSwitchKAWL.count0 = 0xff;
+    awSwitchKAWL.count1 = 0xff;
+    awSwitchKAWR = awSwitchKAWL;
+}
+
+/**
+ * set the motion profile of an AW
+ * @param index: the index of AW in the AW list
+ * @param left: the servo position left (pulse width in µs)
+ * @param right: the servo position right (pulse width in µs)
+ * @param sweep: the sweep time from right to left (in ms)
+ * @param ease: true = ease-in/ease-out, false = linear
+ */
+void awSetProfile(uint8_t index, uint16_t left, uint16_t right,
+        uint16_t sweep, bool ease)
+{
+    awProfile_t* profile = &awProfiles[index];
+    // phase step every 20ms (a sweep time of less than 40ms = 2 periods,
+    // so the middle position can be reached)
+    uint32_t step = (sweep > 40) ? ((uint32_t)AW_PHASE_LEFT * 20 / sweep) :
+            AW_PHASE_MIDDLE - 1;
+
+    profile->left = left;
+    profile->right = right;
+    profile->step = (step != 0) ? (uint16_t)step : 1;
+    profile->ease = ease;
 }
 
 // </editor-fold>
@@ -65,189 +144,459 @@ void awInitPortBC()
 // <editor-fold defaultstate="collapsed" desc="routines">
 
 /**
- * this is the callback function for the AW update
+ * this is the callback function for the AW update (called in the main loop
+ * once per 20ms frame, refer to servoTask)
  * @param index: the index of AW in the AW list
  */
 void awUpdate(uint8_t index)
 {
+    // the AW are the first 8 servos (the other servos are not used)
+    if (index >= 8)
+    {
+        return;
+    }
+
+    // only the main loop writes the servo position, so it can be read here
+    uint16_t position = servoPortD[index];
+
+    // scan the KAW switches of all AW and keep the AW status in the data
+    // EEPROM once per frame (before the first AW)
+    if (index == 0)
+    {
+        awScanSwitches();
+        awNvmTask();
+    }
+
     // update servo on port D
-    awUpdateServo(&aw[index], &servoPortD[index], index);
+    awUpdateServo(&position, index);
+    servoSetPosition(index, position);
 }
 
 /**
- * 
- * @param aw: pointer to the AW parameters
+ * update the servo position and the KAW status of an AW
  * @param servo: pointer to the servo
  * @param index: the index of AW in the AW list
  */
-void awUpdateServo(AWCON_t *aw, uint16_t *servo, uint8_t index)
+void awUpdateServo(uint16_t *servo, uint8_t index)
 {
-    // increment pulse width with gradient depending on state of CAW
-    if (aw->CAWL == aw->CAWR)
+    uint8_t mask = (uint8_t)(1 << index);
+    bool CAWL = ((AWCON.CAWL & mask) != 0);
+    bool CAWR = ((AWCON.CAWR & mask) != 0);
+    uint16_t phase = awPhase[index];
+    uint16_t step = awProfiles[index].step;
+
+    // increment phase with the step depending on state of CAW
+    if (CAWL == CAWR)
     {
         // if CAWL = CAWR clear KAWs and set the servo position in the middle 
-        setKAWL(aw, false, index);
-        setKAWR(aw, false, index);
-        if (*servo > ((SERVO_MAX + SERVO_MIN) / 2) + GRADIENT)
+        setKAWL(mask, 0x00);
+        setKAWR(mask, 0x00);
+        if (phase > AW_PHASE_MIDDLE + step)
+        {
+            phase -= step;
+        }
+        else if (phase < AW_PHASE_MIDDLE - step)
         {
-            *servo -= GRADIENT;
+            phase += step;
         }
-        else if (*servo < ((SERVO_MAX + SERVO_MIN) / 2) - GRADIENT)
+        else
         {
-            *servo += GRADIENT;
+            phase = AW_PHASE_MIDDLE;
         }
     }
     else
     {
         // if CAWL then clear KAWR and set servo left
-        if (aw->CAWL)
+        if (CAWL)
         {
-            setKAWR(aw, index, false);
+            setKAWR(mask, 0x00);
             if (getSwitchKAWL(index))
             {
-                setKAWL(aw, true, index);
+                setKAWL(mask, mask);
             }
             else
             {
-                if (*servo > (SERVO_MAX - GRADIENT))
+                if (phase > (AW_PHASE_LEFT - step))
                 {
-                    *servo = SERVO_MAX;
-                    setKAWL(aw, true, index);
+                    phase = AW_PHASE_LEFT;
+                    setKAWL(mask, mask);
                 }
                 else
                 {
-                    *servo += GRADIENT;
-                    setKAWL(aw, false, index);
+                    phase += step;
+                    setKAWL(mask, 0x00);
                 }                
             }
         }
         // if CAWR then clear KAWL and set servo right
-        if (aw->CAWR)
+        if (CAWR)
         {
-            setKAWL(aw, index, false);
+            setKAWL(mask, 0x00);
             if (getSwitchKAWR(index))
             {
-                setKAWR(aw, true, index);
+                setKAWR(mask, mask);
             }
             else
             {
-                if (*servo < SERVO_MIN + GRADIENT)
+                if (phase < AW_PHASE_RIGHT + step)
                 {
-                    *servo = SERVO_MIN;
-                    setKAWR(aw, true, index);
+                    phase = AW_PHASE_RIGHT;
+                    setKAWR(mask, mask);
                 }
                 else
                 {
-                    *servo -= GRADIENT;
-                    setKAWR(aw, false, index);
+                    phase -= step;
+                    setKAWR(mask, 0x00);
                 }
             }
         }
     }
+    awPhase[index] = phase;
+    *servo = getAwPosition(index);
 }
 
 /**
- * set the property CAWL
- * @param aw: pointer to the AW parameters
- * @param value: true or false (= state of CAWL)
+ * get the servo position of an AW (from the phase of the sweep)
+ * @param index: the index of AW in the AW list
+ * @return the servo position (pulse width in µs)
  */
-void setCAWL(AWCON_t* aw, bool value)
+uint16_t getAwPosition(uint8_t index)
 {
-    // set CAWL and keep old CAW value in memory
-    if (aw->CAWL == true && aw->CAWR == false)
+    awProfile_t* profile = &awProfiles[index];
+    uint8_t phase = (uint8_t)(awPhase[index] >> 8);
+    uint8_t ratio;
+
+    // the end positions are exact
+    if (awPhase[index] == AW_PHASE_LEFT)
     {
-        aw->CAWL_mem = true;
-        aw->CAWR_mem = false;
+        return profile->left;
     }
-    aw->CAWL = value;
+    // one table lookup (ease) or the phase itself (linear)
+    ratio = profile->ease ? awEase[phase] : phase;
+    return (uint16_t)((int32_t)profile->right +
+            (((int32_t)profile->left - (int32_t)profile->right) * ratio) / 256);
 }
 
 /**
- * set the property CAWR
- * @param aw: pointer to the AW parameters
- * @param value: true or false (= state of CAWR)
+ * set the property CAWL of a group of AW
+ * @param mask: the AW to set (bit = index of AW)
+ * @param value: the state of CAWL of these AW (bit = index of AW)
  */
-void setCAWR(AWCON_t* aw, bool value)
+void setCAWL(uint8_t mask, uint8_t value)
 {
-    // set CAWR and keep old CAW value in memory
-    if (aw->CAWR == true && aw->CAWL == false)
-    {
-        aw->CAWR_mem = true;
-        aw->CAWL_mem = false;
-    }
-    aw->CAWR = value;
+    // keep old CAW value in memory (of the AW with CAWL and not CAWR)
+    uint8_t memory = AWCON.CAWL & (uint8_t)~AWCON.CAWR & mask;
+    AWCON.CAWL_mem |= memory;
+    AWCON.CAWR_mem &= (uint8_t)~memory;
+    // set CAWL
+    AWCON.CAWL = (AWCON.CAWL & (uint8_t)~mask) | (value & mask);
 }
 
 /**
- * set the property KAWL
- * @param aw: pointer to the AW parameters
- * @param value: true or false (= state of KAWL)
- * @param index: the index of AW in the AW list
+ * set the property CAWR of a group of AW
+ * @param mask: the AW to set (bit = index of AW)
+ * @param value: the state of CAWR of these AW (bit = index of AW)
  */
-void setKAWL(AWCON_t* aw, bool value, uint8_t index)
+void setCAWR(uint8_t mask, uint8_t value)
+{
+    // keep old CAW value in memory (of the AW with CAWR and not CAWL)
+    uint8_t memory = AWCON.CAWR & (uint8_t)~AWCON.CAWL & mask;
+    AWCON.CAWR_mem |= memory;
+    AWCON.CAWL_mem &= (uint8_t)~memory;
+    // set CAWR
+    AWCON.CAWR = (AWCON.CAWR & (uint8_t)~mask) | (value & mask);
+}
+
+/**
+ * set the property KAWL of a group of AW
+ * @param mask: the AW to set (bit = index of AW)
+ * @param value: the state of KAWL of these AW (bit = index of AW)
+ */
+void setKAWL(uint8_t mask, uint8_t value)
 {
     // set KAWL
-    if (aw->KAWL != value)
+    uint8_t changed = (AWCON.KAWL ^ value) & mask;
+    if (changed != 0)
     {
-        aw->KAWL = value;
+        AWCON.KAWL ^= changed;
         // handle the changed KAW state (in the callback function)
-        (*awCallback)(aw, index);
+        (*awCallback)(changed);
     }
 }
 
 /**
- * set the property KAWR
- * @param aw: pointer to the AW parameters
- * @param value: true or false (= state of KAWR)
- * @param index: the index of AW in the AW list
+ * set the property KAWR of a group of AW
+ * @param mask: the AW to set (bit = index of AW)
+ * @param value: the state of KAWR of these AW (bit = index of AW)
  */
-void setKAWR(AWCON_t* aw, bool value, uint8_t index)
+void setKAWR(uint8_t mask, uint8_t value)
 {
     // set KAWR
-    if (aw->KAWR != value)
+    uint8_t changed = (AWCON.KAWR ^ value) & mask;
+    if (changed != 0)
     {
-        aw->KAWR = value;
+        AWCON.KAWR ^= changed;
         // handle the changed KAW state (in the callback function)
-        (*awCallback)(aw, index);
+        (*awCallback)(changed);
     }
 }
 
 /**
  * get the state of the switch of KAWL
  * @param index: the index of AW in the AW list
- * @return the state of the switch
+ * @return the (debounced) state of the switch
  */
 bool getSwitchKAWL(uint8_t index)
 {
-    bool value = false;
-    
-    // enable KAWL line (active low))
-    LATCbits.LATC4 = false;
-    // get KAWL switch state
-    if ((PORTB & (1 << index)) == 0) { value = true; }    
-    // disable KAWL line (active low)
-    LATCbits.LATC4 = true;    
-    // return the state of the KAWL switch
-    return value;
+    return ((awSwitchKAWL.state & (1 << index)) != 0);
 }
 
 /**
  * get the state of the switch of KAWR
  * @param index: the index of AW in the AW list
- * @return the state of the switch
+ * @return the (debounced) state of the switch
  */
 bool getSwitchKAWR(uint8_t index)
 {
-    bool value = false;
-    
-    // enable KAWR line (active low))
+    return ((awSwitchKAWR.state & (1 << index)) != 0);
+}
+
+/**
+ * scan the KAWL and KAWR switches of all AW (one read of port B per line)
+ * and debounce them
+ */
+void awScanSwitches(void)
+{
+    uint8_t value;
+
+    // enable KAWL line (active low), get the KAWL switches (active low)
+    LATCbits.LATC4 = false;
+    NOP();
+    value = (uint8_t)~PORTB;
+    // disable KAWL line (active low)
+    LATCbits.LATC4 = true;
+    awDebounce(&awSwitchKAWL, value);
+
+    // enable KAWR line (active low), get the KAWR switches (active low)
     LATCbits.LATC5 = false;
-    // get KAWR switch state
-    if ((PORTB & (1 << index)) == 0) { value = true; }    
+    NOP();
+    value = (uint8_t)~PORTB;
     // disable KAWR line (active low)
-    LATCbits.LATC5 = true;    
-    // return the state of the KAWL switch
-    return value;
+    LATCbits.LATC5 = true;
+    awDebounce(&awSwitchKAWR, value);
+}
+
+/**
+ * debounce 8 switches at once with a vertical counter
+ * the state of a switch is changed when the scanned value is 4 times
+ * different from the (debounced) state
+ * @param switches: pointer to the debounced switches
+ * @param value: the scanned switches (bit = index, 1 = switch closed)
+ * @return the switches with a changed state (confirmed edges)
+ */
+uint8_t awDebounce(awSwitches_t* switches, uint8_t value)
+{
+    // switches with a value different from the state
+    uint8_t changed = switches->state ^ value;
+
+    // count these switches down (4 scans) and reset the others
+    switches->count0 = ~(switches->count0 & changed);
+    switches->count1 = switches->count0 ^ (switches->count1 & changed);
+    // change the state of the switches that are counted down
+    changed &= switches->count0 & switches->count1;
+    switches->state ^= changed;
+    return changed;
+}
+
+/**
+ * restore the last AW status from the data EEPROM (warm start)
+ * the AW are set in the commanded position with the KAW status of that
+ * position, so there is no sweep and no report at start-up
+ */
+void awRestore(void)
+{
+    uint8_t record[AW_NVM_RECORD_SIZE];
+    uint8_t next[AW_NVM_RECORD_SIZE];
+
+    // no record: the first record will be written in slot 0
+    awNvm.slot = AW_NVM_RECORDS - 1;
+    awNvm.sequence = 0xff;
+    awNvm.delay = 0;
+    awNvm.index = AW_NVM_RECORD_SIZE;
+    for (uint8_t i = 0; i < AW_NVM_STATUS_SIZE; i++)
+    {
+        awNvm.saved[i] = 0x00;
+        awNvm.status[i] = 0x00;
+    }
+
+    // the last record is the valid record that is not followed by a valid
+    // record with the next sequence number (the records are written in
+    // the order of the ring)
+    for (uint8_t slot = 0; slot < AW_NVM_RECORDS; slot++)
+    {
+        if (!readAwRecord(slot, record))
+        {
+            continue;
+        }
+        if (readAwRecord((slot + 1) % AW_NVM_RECORDS, next) &&
+                (next[0] == (uint8_t)(record[0] + 1)))
+        {
+            continue;
+        }
+        awNvm.slot = slot;
+        awNvm.sequence = record[0];
+        for (uint8_t i = 0; i < AW_NVM_STATUS_SIZE; i++)
+        {
+            awNvm.saved[i] = record[i + 1];
+            awNvm.status[i] = record[i + 1];
+        }
+        break;
+    }
+
+    // set the AW status and the position (phase) of the AW
+    AWCON.CAWL = awNvm.saved[0];
+    AWCON.CAWR = awNvm.saved[1];
+    AWCON.CAWL_mem = awNvm.saved[2];
+    AWCON.CAWR_mem = awNvm.saved[3];
+    AWCON.KAWL = AWCON.CAWL & (uint8_t)~AWCON.CAWR;
+    AWCON.KAWR = AWCON.CAWR & (uint8_t)~AWCON.CAWL;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        uint8_t mask = (uint8_t)(1 << i);
+        if (AWCON.KAWL & mask)
+        {
+            awPhase[i] = AW_PHASE_LEFT;
+        }
+        else if (AWCON.KAWR & mask)
+        {
+            awPhase[i] = AW_PHASE_RIGHT;
+        }
+        else
+        {
+            awPhase[i] = AW_PHASE_MIDDLE;
+        }
+    }
+}
+
+/**
+ * keep the AW status in the data EEPROM (called once per 20ms frame)
+ * a changed status is written when it is stable for AW_NVM_DELAY frames,
+ * the record is written one byte at a time (non-blocking)
+ */
+void awNvmTask(void)
+{
+    uint8_t status[AW_NVM_STATUS_SIZE];
+    bool changed = false;
+    bool saved = true;
+
+    if (awNvm.index < AW_NVM_RECORD_SIZE)
+    {
+        // write the next byte of the record (if the data EEPROM is ready)
+        uint16_t address = (uint16_t)awNvm.slot * AW_NVM_RECORD_SIZE +
+                awNvm.index;
+        if (nvmWrite(address, awNvm.record[awNvm.index]))
+        {
+            awNvm.index++;
+        }
+        return;
+    }
+
+    getAwStatus(status);
+    for (uint8_t i = 0; i < AW_NVM_STATUS_SIZE; i++)
+    {
+        if (status[i] != awNvm.status[i])
+        {
+            changed = true;
+            awNvm.status[i] = status[i];
+        }
+        if (status[i] != awNvm.saved[i])
+        {
+            saved = false;
+        }
+    }
+    if (changed)
+    {
+        // (re)start the coalescing delay
+        awNvm.delay = AW_NVM_DELAY;
+        return;
+    }
+    if (saved)
+    {
+        return;
+    }
+    if (awNvm.delay != 0)
+    {
+        awNvm.delay--;
+        return;
+    }
+
+    // write the status in the next slot of the ring
+    awNvm.slot = (awNvm.slot + 1) % AW_NVM_RECORDS;
+    awNvm.sequence++;
+    awNvm.record[0] = awNvm.sequence;
+    for (uint8_t i = 0; i < AW_NVM_STATUS_SIZE; i++)
+    {
+        awNvm.record[i + 1] = status[i];
+        awNvm.saved[i] = status[i];
+    }
+    awNvm.record[AW_NVM_RECORD_SIZE - 1] = getAwRecordCrc(awNvm.record);
+    awNvm.index = 0;
+}
+
+/**
+ * get the AW status that is kept in the data EEPROM
+ * @param status: the AW status (CAWL, CAWR, CAWL_mem, CAWR_mem)
+ */
+void getAwStatus(uint8_t* status)
+{
+    status[0] = AWCON.CAWL;
+    status[1] = AWCON.CAWR;
+    status[2] = AWCON.CAWL_mem;
+    status[3] = AWCON.CAWR_mem;
+}
+
+/**
+ * read a record of the AW status from the data EEPROM
+ * @param slot: the slot of the record in the ring
+ * @param record: the record
+ * @return true: if the record is valid (check)
+ */
+bool readAwRecord(uint8_t slot, uint8_t* record)
+{
+    for (uint8_t i = 0; i < AW_NVM_RECORD_SIZE; i++)
+    {
+        record[i] = nvmRead((uint16_t)slot * AW_NVM_RECORD_SIZE + i);
+    }
+    return (record[AW_NVM_RECORD_SIZE - 1] == getAwRecordCrc(record));
+}
+
+/**
+ * get the CRC-8 of a record (sequence number and AW status)
+ * the CRC is computed bit by bit (no table in the program memory), an
+ * erased (0xff) or cleared (0x00) record is not valid
+ * @param record: the record
+ * @return the CRC-8 (polynomial AW_NVM_CRC_POLY, start AW_NVM_CRC_INIT)
+ */
+uint8_t getAwRecordCrc(uint8_t* record)
+{
+    uint8_t crc = AW_NVM_CRC_INIT;
+
+    for (uint8_t i = 0; i < AW_NVM_RECORD_SIZE - 1; i++)
+    {
+        crc ^= record[i];
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            if (crc & 0x80)
+            {
+                crc = (uint8_t)((crc << 1) ^ AW_NVM_CRC_POLY);
+            }
+            else
+            {
+                crc = (uint8_t)(crc << 1);
+            }
+        }
+    }
+    return crc;
 }
 
 // </editor-fold>
@@ -5,6 +5,13 @@
  *
  * revision history:
  *  v1.0 Creation (16/08/2024)
+ *  v1.1 Scan and debounce of the KAW switches (16/10/2026)
+ *  v1.2 AW status register as bit masks (one bit per AW) (16/10/2026)
+ *  v1.3 Motion profile per AW (endpoints, sweep time, ease) (16/10/2026)
+ *  v1.4 AW status in the data EEPROM (warm start) (16/10/2026)
+ *  v1.5 CRC-8 of the AW status records (16/10/2026)
+ *  v1.6 Motion profiles at compile time (AW_PROFILES) (16/10/2026)
+ *  v1.7 Unused getAwMoving removed (16/10/2026)
  */
 
 // This is a guard condition so that contents of this file are not included
@@ -14,48 +21,139 @@
 
 #include "config.h"
 #include "servo.h"
+#include "nvm.h"
 
 // definitions
+// default motion profile of the AW (refer to AW_PROFILES)
 // sweeptime time in ms from min/max to max/min position
 #define SWEEPTIME 1500U
-// the puls duration of the servo must be between 1000s and 2000s (SG90)
-#define SERVO_MIN 750U              // max. value = 500 (= -90)
-#define SERVO_MAX 2000U             // max. value = 2250 (= +90)
+// the puls duration of the servo must be between 1000µs and 2000µs (SG90)
+#define SERVO_MIN 750U              // max. value = 500 (= -90°)
+#define SERVO_MAX 2000U             // max. value = 2250 (= +90°)
+// the position of the servo is given by the phase of the sweep (8.8 fixed
+// point, 0x0000 = right (KAWR), 0xffff = left (KAWL))
 // the period for the servo is 20ms
-// so, for a certain sweeptime, the number of steps to add or subtrack is
-// equal to the sweeptime divided by the period (SWEEPTIME / 20)
-// the value (= GRADIENT) to add or subtract is than calculated as follow
-#define GRADIENT (uint8_t)((SERVO_MAX - SERVO_MIN) / (SWEEPTIME / 20))
+// so, for a certain sweeptime, the phase step to add or subtract every
+// period is equal to the phase range divided by (sweeptime / 20)
+#define AW_PHASE_RIGHT 0x0000U
+#define AW_PHASE_MIDDLE 0x8000U
+#define AW_PHASE_LEFT 0xffffU
 
-// AW status register
+// the AW status (CAWL, CAWR, CAWL_mem, CAWR_mem) is kept in the data
+// EEPROM, in a ring of records (wear levelling)
+// record = sequence number, CAWL, CAWR, CAWL_mem, CAWR_mem, CRC-8
+// a changed status is only written when it is not changed anymore during
+// AW_NVM_DELAY periods of 20ms (coalescing)
+#define AW_NVM_STATUS_SIZE 4U
+#define AW_NVM_RECORD_SIZE (AW_NVM_STATUS_SIZE + 2U)
+#define AW_NVM_RECORDS 32U
+#define AW_NVM_DELAY 50U
+// CRC-8 of the record (polynomial x^8 + x^2 + x + 1, start value 0xff)
+#define AW_NVM_CRC_POLY 0x07U
+#define AW_NVM_CRC_INIT 0xffU
+#if (AW_NVM_RECORDS * AW_NVM_RECORD_SIZE) > NVM_SIZE
+#error "the AW records do not fit in the data EEPROM"
+#endif
+
+// AW status in the data EEPROM
+typedef struct
+    {
+        uint8_t slot;           // slot of the last record
+        uint8_t sequence;       // sequence number of the last record
+        uint8_t saved[AW_NVM_STATUS_SIZE];  // status of the last record
+        uint8_t status[AW_NVM_STATUS_SIZE]; // status (coalescing)
+        uint8_t delay;          // coalescing delay (periods of 20ms)
+        uint8_t record[AW_NVM_RECORD_SIZE]; // record that is written
+        uint8_t index;          // next byte of the record to write
+    } awNvm_t;
+
+// motion profile of an AW
+typedef struct
+    {
+        uint16_t left;          // servo position left (pulse width in µs)
+        uint16_t right;         // servo position right (pulse width in µs)
+        uint16_t step;          // phase step every 20ms (sweep time)
+        bool ease;              // ease-in/ease-out (else linear)
+    } awProfile_t;
+
+// configuration of the motion profile of an AW (refer to AW_PROFILES)
 typedef struct
     {
-        bool CAWL;
-        bool CAWR;
-        bool CAWL_mem;
-        bool CAWR_mem;
-        bool KAWL;
-        bool KAWR;
+        uint16_t left;          // servo position left (pulse width in µs)
+        uint16_t right;         // servo position right (pulse width in µs)
+        uint16_t sweep;         // sweep time from right to left (in ms)
+        bool ease;              // ease-in/ease-out (else linear)
+    } awProfileConfig_t;
+
+// motion profiles of the 8 AW (in the order of the AW list), set at init
+// the default is the linear movement of SERVO_MAX, SERVO_MIN, SWEEPTIME
+// for all AW, another table can be given at compile time, e.g.
+// -DAW_PROFILES="{{2000U, 750U, 1500U, true}, ...}" (8 profiles)
+#ifndef AW_PROFILES
+#define AW_PROFILES { \
+    {SERVO_MAX, SERVO_MIN, SWEEPTIME, false}, \
+    {SERVO_MAX, SERVO_MIN, SWEEPTIME, false}, \
+    {SERVO_MAX, SERVO_MIN, SWEEPTIME, false}, \
+    {SERVO_MAX, SERVO_MIN, SWEEPTIME, false}, \
+    {SERVO_MAX, SERVO_MIN, SWEEPTIME, false}, \
+    {SERVO_MAX, SERVO_MIN, SWEEPTIME, false}, \
+    {SERVO_MAX, SERVO_MIN, SWEEPTIME, false}, \
+    {SERVO_MAX, SERVO_MIN, SWEEPTIME, false}}
+#endif
+
+// AW status register (one bit per AW, bit = index of AW in the AW list)
+typedef struct
+    {
+        uint8_t CAWL;
+        uint8_t CAWR;
+        uint8_t CAWL_mem;
+        uint8_t CAWR_mem;
+        uint8_t KAWL;
+        uint8_t KAWR;
     } AWCON_t;
 AWCON_t AWCON;
 
+// debounced KAW switches (one bit per AW, 1 = switch closed)
+// a switch state is changed after 4 equal scans (vertical counter, one
+// counter of 2 bits per switch in count0/count1)
+typedef struct
+    {
+        uint8_t state;
+        uint8_t count0;
+        uint8_t count1;
+    } awSwitches_t;
+
 // AW callback definition (as function pointer)
-typedef void (*awCallback_t)(AWCON_t*, uint8_t);
+// (the argument is the mask of the AW with a changed KAW status)
+typedef void (*awCallback_t)(uint8_t);
 
 // routines
 void awInit(awCallback_t);
 void awInitPortBC(void);
 void awUpdate(uint8_t);
-void awUpdateServo(AWCON_t*, uint16_t*, uint8_t);
-void setCAWL(AWCON_t*, bool);
-void setCAWR(AWCON_t*, bool);
-void setKAWL(AWCON_t*, bool, uint8_t);
-void setKAWR(AWCON_t*, bool, uint8_t);
+void awUpdateServo(uint16_t*, uint8_t);
+void setCAWL(uint8_t, uint8_t);
+void setCAWR(uint8_t, uint8_t);
+void setKAWL(uint8_t, uint8_t);
+void setKAWR(uint8_t, uint8_t);
 bool getSwitchKAWL(uint8_t);
 bool getSwitchKAWR(uint8_t);
+void awScanSwitches(void);
+uint8_t awDebounce(awSwitches_t*, uint8_t);
+void awSetProfile(uint8_t, uint16_t, uint16_t, uint16_t, bool);
+uint16_t getAwPosition(uint8_t);
+void awRestore(void);
+void awNvmTask(void);
+void getAwStatus(uint8_t*);
+bool readAwRecord(uint8_t, uint8_t*);
+uint8_t getAwRecordCrc(uint8_t*);
 
 // variables
 awCallback_t awCallback;
-AWCON_t aw[8];
+awSwitches_t awSwitchKAWL;
+awSwitches_t awSwitchKAWR;
+awProfile_t awProfiles[8];
+uint16_t awPhase[8];                // phase of the sweep (8.8 fixed point)
+awNvm_t awNvm;
 
 #endif	/* AW_H */
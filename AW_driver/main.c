@@ -5,6 +5,18 @@
  *
  * revision history:
  *  v1.0 creation (16/08/2024)
+ *  v1.1 Handle the LN RX messages in the main loop (lnPoll) (16/10/2026)
+ *  v1.2 RX filter and cached DIP switch address (16/10/2026)
+ *  v1.3 Answer a statistics query (OPC_PEER_XFER) (16/10/2026)
+ *  v1.4 Turnout sensor reports in the high priority LN TX class (16/10/2026)
+ *  v1.5 DIP switch address as seed of the LN random generator (16/10/2026)
+ *  v1.6 Transmit the LN messages from a buffer (lnTxSend) (16/10/2026)
+ *  v1.7 Retry of the rejected turnout sensor reports (16/10/2026)
+ *  v1.8 Coalescing of the turnout sensor reports per AW (16/10/2026)
+ *  v1.9 Precomputed turnout sensor reports (16/10/2026)
+ *  v1.10 AW update in the main loop (16/10/2026)
+ *  v1.11 AW status as bit masks (power OFF/ON of all AW at once) (16/10/2026)
+ *  v1.12 Turnout sensor reports built before the AW init (16/10/2026)
  */
 
 #include "config.h"
@@ -12,12 +24,23 @@
 #include "aw.h"
 
 // declarations routines and variables
-void lnRxMessageHandler(lnQueue_t*);
-void awHandler(AWCON_t*, uint8_t);
+void lnRxMessageHandler(lnFrameQueue_t*);
+void awHandler(uint8_t);
+bool sendSensorReport(uint8_t);
+void buildSensorReports(void);
+void flushSensorReports(void);
 void initPinIO(void);
 uint8_t getDipSwitchAddress(void);
+void setDipSwitchAddress(uint8_t);
+void lnStatsHandler(lnFrameQueue_t*);
 
-lnQueue_t lnTxMsg;
+// statistics query: OPC_PEER_XFER with D1 = LN_STATS_QUERY and D2 = page
+#define LN_STATS_QUERY 0x53
+
+uint8_t dipSwitchAddress;           // cached address of the DIP switches
+uint8_t awReportDirty;              // AW with a report to send (bit = index)
+uint8_t awReports[8][4][4];         // ready-made 'turnout sensor state
+                                    // reports' (AW index, KAWL/KAWR state)
 
 /**
  * main (start of program)
@@ -28,93 +51,219 @@ void main(void)
     initPinIO();
     // init the LN driver and give the function pointer for the callback
     lnInit(&lnRxMessageHandler);
-    // init the aw driver
-    awInit(&awHandler);    
-    // init a temporary LN message queue for transmitting a LN message
-    initQueue(&lnTxMsg);
+    // only accept the LN messages that are handled by this device
+    lnInitRxFilter(false);
+    lnSetRxFilter(0xb0, true);      // switch function request (addressed)
+    lnSetRxFilter(0x82, false);     // global power OFF request
+    lnSetRxFilter(0x83, false);     // global power ON request
+    lnSetRxFilter(0xe5, false);     // peer to peer transfer (statistics)
+    setDipSwitchAddress(getDipSwitchAddress());
+    // devices on the same LN get other CMP delays
+    lnSeedRandom(dipSwitchAddress);
+    // init the aw driver (after the reports are built with the address,
+    // the AW handler may already be called in awInit)
+    awInit(&awHandler);
 
     // main loop
+    uint16_t ms = 0;
     while (true)        
     {
-        // in fact, there is nothing to do here
-        // so make just a blinking led (with a period of 1 sec.)
+        // handle the received LN messages (outside the ISR)
+        lnPoll();
+        // update the AW (servo positions and KAW status) once per 20ms
+        // frame, the AW handler is called here (outside the ISR)
+        servoTask();
+        // send the coalesced reports when the high priority LN TX queue is
+        // empty
+        if ((awReportDirty != 0) &&
+                isFrameQueueEmpty(&lnTxQueue[LN_TX_PRIORITY_HIGH]))
+        {
+            flushSensorReports();
+        }
+        // update the address if the DIP switches are changed
+        uint8_t address = getDipSwitchAddress();
+        if (address != dipSwitchAddress)
+        {
+            setDipSwitchAddress(address);
+        }
+        // make a blinking led (with a period of 1 sec.)
         // to show that the device is running
-        LATEbits.LATE0 = true;      // led 'data on (active high)
-        __delay_ms(20);
-        LATEbits.LATE0 = false;     // led 'data off (active high)
-        __delay_ms(980);
+        LATEbits.LATE0 = (ms < 20);     // led 'data on/off (active high)
+        __delay_ms(1);
+        if (++ms >= 1000)
+        {
+            ms = 0;
+        }
     }    
     return;
 }
 
 /**
  * this is the callback function for the LN receiver
- * @param lnRxMsg: the lN message queue
+ * @param lnRxMsg: the LN message (frame) queue
  */
-void lnRxMessageHandler(lnQueue_t* lnRxMsg)
+void lnRxMessageHandler(lnFrameQueue_t* lnRxMsg)
 {
-    while (!isQueueEmpty(lnRxMsg))
+    while (!isFrameQueueEmpty(lnRxMsg))
     {
         // analyse the received LN message from queue
-        switch (lnRxMsg->values[lnRxMsg->head])
+        switch (peekFrame(lnRxMsg, 0))
         {
             case 0xb0:
             {
                 // switch function request
-                uint8_t index;
-                uint8_t address;
+                // (the address is already checked by the RX filter)
+                uint8_t mask;
 
-                index = lnRxMsg->values[lnRxMsg->head + 1] & 0x07;
-                address = (lnRxMsg->values[lnRxMsg->head + 1] & 0x78) >> 3;
-                address += (lnRxMsg->values[lnRxMsg->head + 2] & 0x0f) << 4;
-
-                if (address == getDipSwitchAddress())
+                mask = (uint8_t)(1 << (peekFrame(lnRxMsg, 1) & 0x07));
+                if ((peekFrame(lnRxMsg, 2) & 0x20) == 0x20)
+                {
+                    setCAWL(mask, mask);
+                    setCAWR(mask, 0x00);
+                }
+                else
                 {
-                    if ((lnRxMsg->values[lnRxMsg->head + 2] & 0x20) == 0x20)
-                    {
-                        setCAWL(&aw[index], true);
-                        setCAWR(&aw[index], false);
-                    }
-                    else
-                    {
-                        setCAWL(&aw[index], false);
-                        setCAWR(&aw[index], true);
-                    }
+                    setCAWL(mask, 0x00);
+                    setCAWR(mask, mask);
                 }
                 break;
             }
             case 0x82:
             {
-                // global power OFF request
-                for (uint8_t index = 0; index < 8; index++)
-                {
-                        setCAWL(&aw[index], false);
-                        setCAWR(&aw[index], false);
-                }
+                // global power OFF request (all AW)
+                setCAWL(0xff, 0x00);
+                setCAWR(0xff, 0x00);
                 break;               
             }
             case 0x83:
             {
-                // global power ON request
-                for (uint8_t index = 0; index < 8; index++)
-                {
-                        setCAWL(&aw[index], aw[index].CAWL_mem);
-                        setCAWR(&aw[index], aw[index].CAWR_mem);
-                }
+                // global power ON request (all AW)
+                setCAWL(0xff, AWCON.CAWL_mem);
+                setCAWR(0xff, AWCON.CAWR_mem);
+                break;
+            }
+            case 0xe5:
+            {
+                // peer to peer transfer (statistics query)
+                lnStatsHandler(lnRxMsg);
                 break;
             }
         }
         // clear the received LN message from queue
-        deQueue(lnRxMsg);
+        deQueueFrame(lnRxMsg);
     }
 }
 
+/**
+ * answer a statistics query of the LN driver
+ * the query and the reply are an OPC_PEER_XFER message (16 bytes):
+ * 0xE5, 0x10, SRC, DSTL, DSTH, PXCT1, D1 - D4, PXCT2, D5 - D8, CHK
+ * (PXCT1/PXCT2 = bit 7 of D1 - D4/D5 - D8)
+ * query: DSTL/DSTH = DIP switch address, D1 = LN_STATS_QUERY, D2 = page
+ * reply: SRC = DIP switch address, DSTL = SRC of the query, DSTH = 0,
+ *        D1 - D8 = page of the statistics (refer to getLnStats)
+ * @param lnRxMsg: the LN message (frame) queue
+ */
+void lnStatsHandler(lnFrameQueue_t* lnRxMsg)
+{
+    uint8_t data[8];
+    uint8_t lnTxMsg[15];
+    uint8_t length = 0;
+
+    if ((getFrameLength(lnRxMsg) != 0x10) ||
+            (peekFrame(lnRxMsg, 3) != (dipSwitchAddress & 0x7f)) ||
+            (peekFrame(lnRxMsg, 4) != (dipSwitchAddress >> 7)) ||
+            (peekFrame(lnRxMsg, 6) != LN_STATS_QUERY))
+    {
+        return;
+    }
+    getLnStats(peekFrame(lnRxMsg, 7), data);
+
+    lnTxMsg[length++] = 0xe5;
+    lnTxMsg[length++] = 0x10;
+    lnTxMsg[length++] = dipSwitchAddress & 0x7f;
+    lnTxMsg[length++] = peekFrame(lnRxMsg, 2);
+    lnTxMsg[length++] = 0x00;
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if ((i & 0x03) == 0)
+        {
+            // PXCT byte with the msb of the next 4 data bytes
+            uint8_t pxct = 0;
+            for (uint8_t j = 0; j < 4; j++)
+            {
+                pxct |= (uint8_t)((data[i + j] >> 7) << j);
+            }
+            lnTxMsg[length++] = pxct;
+        }
+        lnTxMsg[length++] = data[i] & 0x7f;
+    }
+    // transmit the LN message (normal priority class, the main loop is
+    // the only producer of this class)
+    lnTxSend(lnTxMsg, length);
+}
+
 /**
  * this is the callback function for the AW (when the KAW status is changed)
- * @param aw: the AW parameters
+ * it is called in the main loop (refer to servoTask)
+ * @param mask: the AW with a changed KAW status (bit = index of AW)
+ */
+void awHandler(uint8_t mask)
+{
+    // mark the reports of the AW as dirty, a report is made when it is
+    // sent (with the KAW status of that moment), so a KAW status that is
+    // changed again before it is sent is never transmitted
+    awReportDirty |= mask;
+    // send the reports at once if the high priority LN TX queue is empty,
+    // otherwise the reports are coalesced till the queue is empty (refer
+    // to the main loop)
+    if (isFrameQueueEmpty(&lnTxQueue[LN_TX_PRIORITY_HIGH]))
+    {
+        flushSensorReports();
+    }
+}
+
+/**
+ * send the reports of all dirty AW (from the producer of the high priority
+ * LN TX class), a report stays dirty if the LN TX queue is full
+ */
+void flushSensorReports(void)
+{
+    for (uint8_t index = 0; index < 8; index++)
+    {
+        if ((awReportDirty & (1 << index)) != 0)
+        {
+            if (!sendSensorReport(index))
+            {
+                break;
+            }
+            awReportDirty &= (uint8_t)~(1 << index);
+        }
+    }
+}
+
+/**
+ * transmit a 'turnout sensor state report' with the actual KAW status
  * @param index: the index of AW in the AW list
+ * @return true: if the report is queued, false: if the LN TX queue is full
+ */
+bool sendSensorReport(uint8_t index)
+{
+    // state = KAWL (bit 1), KAWR (bit 0)
+    uint8_t state = (uint8_t)((((AWCON.KAWL >> index) & 0x01) << 1) |
+            ((AWCON.KAWR >> index) & 0x01));
+
+    // transmit the LN message (high priority class, the AW handler in the
+    // main loop is the only producer of this class)
+    return (lnTxPrioritySendRaw(awReports[index][state], 4,
+            LN_TX_PRIORITY_HIGH) == LN_TX_OK);
+}
+
+/**
+ * build the 'turnout sensor state reports' (checksum included) of all AW
+ * and KAWL/KAWR states for the (cached) DIP switch address
  */
-void awHandler(AWCON_t* aw, uint8_t index)
+void buildSensorReports(void)
 {
     // create a 'turnout sensor state report'
     // reference https://wiki.rocrail.net/doku.php?id=loconet:ln-pe-en
@@ -129,21 +278,25 @@ void awHandler(AWCON_t* aw, uint8_t index)
     //       (A7 - A10 = DIP switches 4 - 7)
     //       (C = KAWL, T = KAWR)
 
-    // get DIP switch address
-    uint16_t address = getDipSwitchAddress();
-    
-    // make arguments SN1, SN2
-    uint8_t SN1 = ((uint8_t)((address << 3) & 0x00f8) + index) & 0x7f;
-    uint8_t SN2 = (uint8_t)(address >> 4) & 0x0f;
-    if (aw->KAWR) { SN2 |= 0x10; }
-    if (aw->KAWL) { SN2 |= 0x20; }
-    
-    // enqueue message
-    enQueue(&lnTxMsg, 0xB1);
-    enQueue(&lnTxMsg, SN1);
-    enQueue(&lnTxMsg, SN2);
-    // transmit the LN message
-    lnTxMessageHandler(&lnTxMsg);    
+    // get DIP switch address (cached)
+    uint16_t address = dipSwitchAddress;
+
+    for (uint8_t index = 0; index < 8; index++)
+    {
+        for (uint8_t state = 0; state < 4; state++)
+        {
+            uint8_t* report = awReports[index][state];
+            // make arguments SN1, SN2
+            uint8_t SN1 = ((uint8_t)((address << 3) & 0x00f8) + index) & 0x7f;
+            uint8_t SN2 = (uint8_t)(address >> 4) & 0x0f;
+            if (state & 0x01) { SN2 |= 0x10; }
+            if (state & 0x02) { SN2 |= 0x20; }
+            report[0] = 0xB1;
+            report[1] = SN1;
+            report[2] = SN2;
+            report[3] = 0xff ^ 0xB1 ^ SN1 ^ SN2;
+        }
+    }
 }
 
 /**
@@ -192,3 +345,17 @@ uint8_t getDipSwitchAddress()
 
     return address;
 }
+
+/**
+ * set the (cached) address of the DIP switches, the RX filter and the
+ * turnout sensor reports
+ * @param address: the address (or value of the DIP switches)
+ */
+void setDipSwitchAddress(uint8_t address)
+{
+    dipSwitchAddress = address;
+    // A10 - A3 of the switch address = DIP switches, A2 - A0 = index of AW
+    lnSetRxFilterAddress((uint16_t)address << 3, 0x07f8);
+    // the reports are only built again when the address is changed
+    buildSensorReports();
+}
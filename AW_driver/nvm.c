@@ -0,0 +1,64 @@
+/*
+ * file: nvm.c
+ * author: J. van Hooydonk
+ * comments: data EEPROM driver
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Region selection with the NVMCON1 register (16/10/2026)
+ *  v1.2 Unused isNvmBusy removed (nvmWrite tests the busy flag) (16/10/2026)
+*/
+
+#include "nvm.h"
+
+// <editor-fold defaultstate="collapsed" desc="routines">
+
+/**
+ * read a byte of the data EEPROM
+ * @param address: the address in the data EEPROM
+ * @return the value
+ */
+uint8_t nvmRead(uint16_t address)
+{
+    // the region bits (NVMCON1<7:6>) are REG<1:0> in the Q10 data sheet,
+    // but NVMREG<1:0> in the headers of some other PIC18 families, so the
+    // register is written as a byte (REG = 0b00: access data EEPROM)
+    NVMCON1 = 0x00;
+    NVMADRH = (uint8_t)(address >> 8);
+    NVMADRL = (uint8_t)address;
+    NVMCON1bits.RD = true;      // start the read (1 cycle)
+    return NVMDAT;
+}
+
+/**
+ * start the write of a byte in the data EEPROM (non-blocking)
+ * the write takes a few ms, a next write is refused (false) until the data
+ * EEPROM is not busy anymore
+ * @param address: the address in the data EEPROM
+ * @param value: the value
+ * @return true: if the write is started, false: if the data EEPROM is busy
+ */
+bool nvmWrite(uint16_t address, uint8_t value)
+{
+    if (NVMCON1bits.WR)
+    {
+        return false;
+    }
+    NVMCON1 = 0x00;             // REG = 0b00: access data EEPROM
+    NVMADRH = (uint8_t)(address >> 8);
+    NVMADRL = (uint8_t)address;
+    NVMDAT = value;
+    NVMCON1bits.WREN = true;    // enable the write
+    // the unlock sequence may not be interrupted (GIEH = false disables
+    // all interrupts)
+    bool gieh = INTCONbits.GIEH;
+    INTCONbits.GIEH = false;
+    NVMCON2 = 0x55;
+    NVMCON2 = 0xaa;
+    NVMCON1bits.WR = true;      // start the write
+    INTCONbits.GIEH = gieh;
+    NVMCON1bits.WREN = false;   // disable the write (the write continues)
+    return true;
+}
+
+// </editor-fold>
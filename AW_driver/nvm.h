@@ -0,0 +1,27 @@
+/* 
+ * file: nvm.h
+ * author: J. van Hooydonk
+ * comments: data EEPROM driver
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Unused isNvmBusy removed (16/10/2026)
+ */
+
+// This is a guard condition so that contents of this file are not included
+// more than once.  
+#ifndef NVM_H
+#define	NVM_H
+
+#include "config.h"
+
+// definitions
+// size of the data EEPROM (the smallest device of the family with port D,
+// PIC18F45Q10 = 256 bytes)
+#define NVM_SIZE 256U
+
+// routines
+uint8_t nvmRead(uint16_t);
+bool nvmWrite(uint16_t, uint8_t);
+
+#endif	/* NVM_H */
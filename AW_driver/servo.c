@@ -5,6 +5,17 @@
  *
  * revision history:
  *  v1.0 Creation (16/08/2024)
+ *  v1.1 Servo callback in the main loop (servoTask) (16/10/2026)
+ *  v1.2 Precomputed next slot (fixed time pulse start) (16/10/2026)
+ *  v1.3 Groups of 8 servos with overlapped pulses (SERVO_COUNT) (16/10/2026)
+ *  v1.4 Start positions given by the servo callback (16/10/2026)
+ *  v1.5 Idle servos without pulses, idle slots in one timer 3 period
+ *       (16/10/2026)
+ *  v1.6 Pulse ends that are passed are ended at once (16/10/2026)
+ *  v1.7 Interrupt state kept by servoSetPosition (16/10/2026)
+ *  v1.8 Frame precomputed in the main loop (servoTask) (16/10/2026)
+ *  v1.9 Merged pulses end with the longest pulse (16/10/2026)
+ *  v1.10 Comments of the timer 3 initialisation (16/10/2026)
 */
 
 #include "servo.h"
@@ -21,11 +32,32 @@ void servoInit(servoCallback_t fptr)
     servoCallback = fptr;
 
     // initialisation of the servo variables
-    for (uint8_t i = 0; i < 8; i++)
+    for (uint8_t i = 0; i < SERVO_COUNT; i++)
     {
         servoPortD[i] = 1500U;
+        servoHold[i] = SERVO_HOLD;
+    }
+    // all servos get pulses after a restart (until their hold time is over)
+    for (uint8_t i = 0; i < SERVO_GROUPS; i++)
+    {
+        servoEnabled[i] = 0xff;
     }
-    pinIndex = 0;
+    // the start positions are given by the servo callback (so the first
+    // pulses are already in the right position, e.g. after a restart)
+    for (uint8_t i = 0; i < SERVO_COUNT; i++)
+    {
+        (*servoCallback)(i);
+    }
+    // the first frame is precomputed at once, it is started by the first
+    // timer 3 interrupt (there are no pulse ends before that interrupt)
+    servoActive = 0x01;
+    servoPrepareFrame();
+    servoActive = 0x00;
+    servoFrameReady = false;
+    servoSlotIndex = 0;
+    servoSlot = &servoFrames[0].slots[0];
+    servoEndIndex = 8;
+    servoFrameFlag = false;
     
     // init of the other elements (timer, comparator, IST, port)
     servoInitTmr3();
@@ -39,14 +71,16 @@ void servoInit(servoCallback_t fptr)
  */
 void servoInitTmr3(void)
 {
-    // timer 3 must give a high interrupt every 2500s so that 8 servos
-    // will give a 20ms frame rate
+    // timer 3 must give a high interrupt every 2500µs so that 8 slots
+    // (groups of servos) will give a 20ms frame rate
     TMR3CLK = 0x01;             // clock source to Fosc / 4
-    T3CON = 0b00110000;         // T3CKPS = 0b11 (1:8 prescaler)
+    T3CON = 0b00110010;         // T3CKPS = 0b11 (1:8 prescaler)
                                 // SYNC = 0 (ignored)
-                                // RD16 = 0 (timer 3 in 8 bit operation)
-                                // TMR1ON = 0 (timer 3 is disabled)
-    WRITETIMER3(~TIMER3_2500us);// set delay in timer 1
+                                // RD16 = 1 (timer 3 in 16 bit operation,
+                                // the ISR reads the timer in one step)
+                                // ON = 0 (timer 3 is disabled)
+    WRITETIMER3(~TIMER3_2500us);// set delay in timer 3 (the 16 bit write
+                                // goes through the high byte buffer)
 }
 
 /**
@@ -58,7 +92,7 @@ void servoInitCcp1(void)
     CCPTMRSbits.C1TSEL = 2;     // CCP1 is based of timer 3
     CCP1CONbits.MODE = 8;       // set output mode
     CCP1CONbits.EN = true;      // enable comparator (CCP1)    
-    CCPR1 = ~(TIMER3_2500us - (servoPortD[pinIndex] * 2));
+    CCPR1 = servoFrames[servoActive].slots[0].ends[0];
 }
 
 /**
@@ -80,13 +114,179 @@ void servoInitIsr(void)
 }
 
 /**
- * servo motor driver initialisation of the output port D (= 8 servos)
+ * servo motor driver initialisation of the output port D (= group 0)
  */
 void servoInitPortD(void)
 {
     // port D
     TRISD = 0x00;               // configure all pins of port D as output
     LATD = 0x00;                // set them to 0    
+#if SERVO_ISR_PROBE
+    // port E, bit 2 as digital output (ISR probe)
+    TRISEbits.TRISE2 = false;
+    LATEbits.LATE2 = false;
+#endif
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="routines">
+
+/**
+ * servo task (to be called in the main loop)
+ * the servo callback is called for all servos once per 20ms frame, so the
+ * servo positions are calculated outside the high priority interrupt, the
+ * next frame is precomputed here as well (the ISR only starts and ends the
+ * pulses with the precomputed values)
+ */
+void servoTask(void)
+{
+    if (servoFrameFlag)
+    {
+        servoFrameFlag = false;
+        for (uint8_t i = 0; i < SERVO_COUNT; i++)
+        {
+            // get servo values (in the callback function)
+            (*servoCallback)(i);
+            // a servo that keeps its position is idle after the hold time
+            // (the enabled bits are only written in the main loop)
+            if (servoHold[i] != 0)
+            {
+                servoHold[i]--;
+                if (servoHold[i] == 0)
+                {
+                    servoEnabled[i >> 3] &= (uint8_t)~(1 << (i & 0x07));
+                }
+            }
+        }
+        // precompute the next frame, if the last precomputed frame is
+        // already started by the ISR (otherwise the next frame is
+        // precomputed in the next frame)
+        if (!servoFrameReady)
+        {
+            servoPrepareFrame();
+        }
+    }
+}
+
+/**
+ * set the position of a servo
+ * a new position (re)starts the pulses of the servo for the hold time
+ * @param index: the index of the servo (0 - SERVO_COUNT - 1)
+ * @param value: the pulse width (in µs)
+ */
+void servoSetPosition(uint8_t index, uint16_t value)
+{
+    if (value != servoPortD[index])
+    {
+        // the positions are only read in the main loop (servoPrepareFrame),
+        // so no interrupts are held off
+        servoPortD[index] = value;
+        servoHold[index] = SERVO_HOLD;
+        servoEnabled[index >> 3] |= (uint8_t)(1 << (index & 0x07));
+    }
+}
+
+/**
+ * precompute the next frame (in the main loop): the slots of the groups
+ * with enabled servos (in the order of the groups) and one idle slot for
+ * the rest of the frame, the groups without enabled servos are skipped
+ * the frame is started by the ISR at the start of the next frame
+ */
+void servoPrepareFrame(void)
+{
+    servoFrame_t* frame = &servoFrames[servoActive ^ 0x01];
+    uint8_t count = 0;
+
+    for (uint8_t group = 0; group < SERVO_GROUPS; group++)
+    {
+        if (servoEnabled[group] != 0)
+        {
+            servoPrepareSlot(&frame->slots[count], group);
+            count++;
+        }
+    }
+    if (count < 8)
+    {
+        // idle slot until the end of the frame (no pulses), the compare
+        // value is never reached (the timer starts after it)
+        servoSlot_t* slot = &frame->slots[count];
+        slot->group = SERVO_IDLE;
+        slot->reload = (uint16_t)(0x10000UL -
+                (uint32_t)(8 - count) * SERVO_SLOT_TICKS);
+        slot->start = 0x00;
+        slot->count = 0;
+        slot->ends[0] = slot->reload - 1;
+        count++;
+    }
+    frame->count = count;
+    servoFrameReady = true;
+}
+
+/**
+ * precompute a slot: the group of servos, the start pattern and the pulse
+ * ends of the enabled servos sorted by their compare value
+ * @param slot: the slot
+ * @param group: the group of servos (with enabled servos)
+ */
+void servoPrepareSlot(servoSlot_t* slot, uint8_t group)
+{
+    uint16_t* position = &servoPortD[group << 3];
+    uint8_t enabled = servoEnabled[group];
+    uint8_t masks[8];
+    uint8_t count = 0;
+
+    slot->group = group;
+    slot->reload = (uint16_t)~TIMER3_2500us;
+    slot->ends[0] = 0xffff;
+    // sort the pulse ends of the enabled servos (insertion sort)
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if ((enabled & (1 << i)) == 0)
+        {
+            continue;
+        }
+        uint16_t end = ~(TIMER3_2500us - (position[i] * 2));
+        uint8_t k = count;
+        while ((k > 0) && (slot->ends[k - 1] > end))
+        {
+            slot->ends[k] = slot->ends[k - 1];
+            masks[k] = masks[k - 1];
+            k--;
+        }
+        slot->ends[k] = end;
+        masks[k] = (uint8_t)(0x01 << i);
+        count++;
+    }
+    // merge the pulse ends that are too close for two interrupts, the
+    // merged pulses end with the latest (longest) pulse
+    uint8_t n = 1;
+    uint16_t first = slot->ends[0];
+    for (uint8_t k = 1; k < count; k++)
+    {
+        if ((uint16_t)(slot->ends[k] - first) < SERVO_END_GAP)
+        {
+            slot->ends[n - 1] = slot->ends[k];
+            masks[n - 1] |= masks[k];
+        }
+        else
+        {
+            first = slot->ends[k];
+            slot->ends[n] = slot->ends[k];
+            masks[n] = masks[k];
+            n++;
+        }
+    }
+    count = n;
+    // port patterns (all pulses start at once)
+    uint8_t pattern = enabled;
+    slot->start = pattern;
+    for (uint8_t k = 0; k < count; k++)
+    {
+        pattern &= (uint8_t)~masks[k];
+        slot->patterns[k] = pattern;
+    }
+    slot->count = count;
 }
 
 // </editor-fold>
@@ -103,6 +303,9 @@ void servoInitPortD(void)
  */
 void __interrupt(high_priority) servoIsr(void)
 {
+#if SERVO_ISR_PROBE
+    LATEbits.LATE2 = true;
+#endif
     if (PIR4bits.TMR3IF)
     {
         // timer 3 interrupt
@@ -117,6 +320,9 @@ void __interrupt(high_priority) servoIsr(void)
         PIR6bits.CCP1IF = false;
         servoIsrCcp1();
     }
+#if SERVO_ISR_PROBE
+    LATEbits.LATE2 = false;
+#endif
 }
 
 // </editor-fold>
@@ -128,21 +334,38 @@ void __interrupt(high_priority) servoIsr(void)
  */
 void servoIsrTmr3(void)
 {
-    // increment pin index
-    pinIndex++;
-    if (pinIndex == 8)
-    {
-        pinIndex = 0;
-    }
-    // get servo values (in the callback function)
-    (*servoCallback)(pinIndex);
-    // set comparator (CCP1)
-    CCPR1 = ~(TIMER3_2500us - (servoPortD[pinIndex] * 2));
-    // toggle output port D pin[pinIndex]
-    LATD = (uint8_t)(0x01 << pinIndex);
-    // reload timer 3
-    // the timer must be started after all previous setting are done
-    WRITETIMER3(~TIMER3_2500us);// set delay in timer 3
+    if (servoSlotIndex == 0)
+    {
+        // start of a new 20ms frame, the precomputed frame (if ready) is the
+        // actual frame (the servo callback is called in the main loop,
+        // refer to servoTask)
+        if (servoFrameReady)
+        {
+            servoActive ^= 0x01;
+            servoFrameReady = false;
+        }
+        servoFrameFlag = true;
+    }
+    servoFrame_t* frame = &servoFrames[servoActive];
+    servoSlot_t* slot = &frame->slots[servoSlotIndex];
+
+    // start the pulses of the slot with the precomputed values, so the
+    // pulses always start at a fixed time after the timer reload
+    // the timer is reloaded first (the compare values are relative to it)
+    SERVO_HAL_WRITE_TMR3(slot->reload);         // set delay in timer 3
+    if (slot->group != SERVO_IDLE)
+    {
+        SERVO_HAL_WRITE_PORT(slot->group, slot->start); // set output pins
+    }
+    SERVO_HAL_WRITE_CCPR(slot->ends[0]);        // set comparator (CCP1)
+    servoSlot = slot;
+    servoEndIndex = 0;
+    // next slot of the frame
+    servoSlotIndex++;
+    if (servoSlotIndex >= frame->count)
+    {
+        servoSlotIndex = 0;
+    }
 }
 
 // </editor-fold>
@@ -154,8 +377,32 @@ void servoIsrTmr3(void)
  */
 void servoIsrCcp1(void)
 {
-    // set (all) pin(s) of port D to 0
-    LATD = 0x00;
+    servoSlot_t* slot = servoSlot;
+
+    while (servoEndIndex < slot->count)
+    {
+        // end the pulse(s) with this compare value and set the comparator
+        // (CCP1) to the next pulse end
+        SERVO_HAL_WRITE_PORT(slot->group, slot->patterns[servoEndIndex]);
+        servoEndIndex++;
+        if (servoEndIndex < slot->count)
+        {
+            uint16_t end = slot->ends[servoEndIndex];
+            SERVO_HAL_WRITE_CCPR(end);
+            PIR6bits.CCP1IF = false;
+            // a compare value that the timer has already passed gives no
+            // match (the pulse would last till the next frame), so that
+            // pulse is ended at once (a bit late, the ISR took longer than
+            // the gap between the pulse ends)
+            // the flag is cleared before the timer is read, so a match of
+            // a pulse end that is ended here does not end the next one
+            int16_t ahead = (int16_t)(end - SERVO_HAL_READ_TMR3());
+            if (ahead >= (int16_t)SERVO_END_MARGIN)
+            {
+                break;
+            }
+        }
+    }
 }
 
 // </editor-fold>
@@ -5,6 +5,12 @@
  *
  * revision history:
  *  v1.0 Creation (16/08/2024)
+ *  v1.1 Servo callback in the main loop (servoTask) (16/10/2026)
+ *  v1.2 Precomputed next slot (fixed time pulse start) (16/10/2026)
+ *  v1.3 Groups of 8 servos with overlapped pulses (SERVO_COUNT) (16/10/2026)
+ *  v1.4 Idle servos without pulses (SERVO_HOLD) (16/10/2026)
+ *  v1.5 Pulse end gap from the comparator ISR time (16/10/2026)
+ *  v1.6 Frame precomputed in the main loop (servoTask) (16/10/2026)
  */
 
 // This is a guard condition so that contents of this file are not included
@@ -16,6 +22,71 @@
 
 // definitions
 #define TIMER3_2500us 5000U
+// length of one slot (in ticks of 0.5µs), a 20ms frame has 8 slots
+#define SERVO_SLOT_TICKS (TIMER3_2500us + 1U)
+// group of the idle slot (the rest of the frame after the last group with
+// pulses, one timer 3 period)
+#define SERVO_IDLE 0xffU
+// a pulse end that the timer has (nearly) passed when the comparator is
+// set, is ended at once (in ticks of 0.5µs, refer to servoIsrCcp1)
+#define SERVO_END_MARGIN 2U
+
+// options
+// number of servos, the servos are driven in groups of 8 (one port per
+// group), every group starts its 8 pulses at once in its own 2500µs slot
+// of the 20ms frame (8 slots, so 8 to 64 servos)
+// group 0 = port D, the ports of the other groups are given by the board
+// (refer to servo_hal.h)
+#ifndef SERVO_COUNT
+#define SERVO_COUNT 8U
+#endif
+#define SERVO_GROUPS (SERVO_COUNT / 8U)
+#if ((SERVO_COUNT % 8U) != 0) || (SERVO_GROUPS < 1) || (SERVO_GROUPS > 8)
+#error "SERVO_COUNT must be a multiple of 8 (8 - 64)"
+#endif
+
+#include "servo_hal.h"
+// pulse ends (in ticks of 0.5µs) closer than this gap are merged into one
+// comparator interrupt, the merged pulses end with the longest one (a pulse
+// is never shorter than its position, at most SERVO_END_GAP - 1 ticks
+// longer), the default is the margin of the comparator interrupt (only
+// equal or adjacent pulse ends are merged, the other pulse ends that are
+// passed are ended at once by the comparator interrupt)
+#ifndef SERVO_END_GAP
+#define SERVO_END_GAP SERVO_END_MARGIN
+#endif
+// number of frames (20ms) the pulses of a servo continue after its last
+// position change, after that the servo is idle (no pulses and no
+// interrupts) until the next position change (0 = the pulses never stop)
+#ifndef SERVO_HOLD
+#define SERVO_HOLD 25U
+#endif
+// set the probe pin (RE2) high during the high priority interrupt, so the
+// duration of the ISR can be measured with a scope or logic analyser
+#ifndef SERVO_ISR_PROBE
+#define SERVO_ISR_PROBE false
+#endif
+
+// slot of the 20ms frame (one group of 8 servos)
+// the pulses of the group start at once, they are ended in the order of
+// their compare values (shortest pulse first)
+typedef struct
+    {
+        uint8_t group;          // group of servos (port) of the slot
+        uint16_t reload;        // timer 3 value at the start of the slot
+        uint8_t start;          // port pattern at the start of the slot
+        uint8_t count;          // number of pulse ends (comparator)
+        uint16_t ends[8];       // compare values (CCP1) of the pulse ends
+        uint8_t patterns[8];    // port pattern after every pulse end
+    } servoSlot_t;
+
+// 20ms frame: the slots of the groups with enabled servos (in the order of
+// the groups) and one idle slot for the rest of the frame
+typedef struct
+    {
+        uint8_t count;          // number of slots
+        servoSlot_t slots[SERVO_GROUPS + 1];
+    } servoFrame_t;
 
 // servo callback definition (as function pointer)
 typedef void (*servoCallback_t)(uint8_t);
@@ -26,6 +97,10 @@ void servoInitTmr3(void);
 void servoInitCcp1(void);
 void servoInitIsr(void);
 void servoInitPortD(void);
+void servoTask(void);
+void servoSetPosition(uint8_t, uint16_t);
+void servoPrepareFrame(void);
+void servoPrepareSlot(servoSlot_t*, uint8_t);
 
 void servoIsr(void);
 void servoIsrTmr3(void);
@@ -33,7 +108,15 @@ void servoIsrCcp1(void);
 
 // variables
 servoCallback_t servoCallback;
-uint16_t servoPortD[8];
-uint8_t pinIndex;
+uint16_t servoPortD[SERVO_COUNT];   // servo positions (pulse width in µs)
+uint8_t servoEnabled[SERVO_GROUPS]; // servos with pulses (bit per servo)
+uint8_t servoHold[SERVO_COUNT];     // frames until the servo is idle
+servoFrame_t servoFrames[2];        // actual and next (precomputed) frame
+uint8_t servoActive;                // index of the actual frame
+volatile bool servoFrameReady;      // the next frame is precomputed
+servoSlot_t* servoSlot;             // actual slot (pulse ends)
+uint8_t servoSlotIndex;             // next slot of the actual frame
+uint8_t servoEndIndex;              // next pulse end of the actual slot
+volatile bool servoFrameFlag;       // start of a 20ms frame (set by the ISR)
 
 #endif	/* SERVO_H */
@@ -0,0 +1,53 @@
+/*
+ * file: servo_hal.h
+ * author: J. van Hooydonk
+ * comments: servo motor driver, hardware abstraction layer
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Port of a group of servos (16/10/2026)
+ *  v1.2 Read of timer 3 (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef SERVO_HAL_H
+#define	SERVO_HAL_H
+
+#include "config.h"
+
+// the servo driver never touches the port D, timer 3 or CCP1 registers
+// directly in the ISR routines, but it uses the macros below
+// for the PIC18F45/46/47Q10 these macros are the register accesses
+// themselves (so there is no extra overhead), for a host build (LN_HOST
+// defined) they are mapped on the trace of host/servo_trace.c
+// refer to host/servo_hal_host.h
+
+#ifdef LN_HOST
+
+#include "servo_hal_host.h"
+
+#else
+
+// servo outputs: group 0 = port D, the other groups (SERVO_COUNT > 8) are
+// written with SERVO_HAL_WRITE_PORT_GROUP(group, value), to be defined by
+// the board (together with the initialisation of these ports)
+#if SERVO_COUNT > 8
+#ifndef SERVO_HAL_WRITE_PORT_GROUP
+#error "SERVO_HAL_WRITE_PORT_GROUP(group, value) must be defined"
+#endif
+#define SERVO_HAL_WRITE_PORT(group, value) \
+    do { if ((group) == 0) { LATD = (value); } \
+        else { SERVO_HAL_WRITE_PORT_GROUP(group, value); } } while (0)
+#else
+#define SERVO_HAL_WRITE_PORT(group, value) (LATD = (value))
+#endif
+
+// timer 3 and comparator (CCP1)
+#define SERVO_HAL_WRITE_TMR3(value) WRITETIMER3(value)
+#define SERVO_HAL_READ_TMR3() READTIMER3()
+#define SERVO_HAL_WRITE_CCPR(value) (CCPR1 = (value))
+
+#endif	/* LN_HOST */
+
+#endif	/* SERVO_HAL_H */
@@ -5,6 +5,10 @@
  *
  * revision history:
  *  v1.0 Creation (14/01/2024)
+ *  v1.1 Lock-free single producer / single consumer queue (16/10/2026)
+ *  v1.2 Frame queue (LN messages with a descriptor table) (16/10/2026)
+ *  v1.3 Abort of a LN message being written (abortFrame) (16/10/2026)
+ *  v1.4 Overflow counter and high-water mark (16/10/2026)
  */
 
 #include "circular_queue.h"
@@ -15,10 +19,10 @@
  */
 void initQueue(lnQueue_t* queue)
 {
-    queue->size = QUEUE_SIZE;
     queue->head = 0;
     queue->tail = 0;
-    queue->numEntries = 0;
+    queue->peak = 0;
+    queue->overflows = 0;
 }
 
 /**
@@ -28,16 +32,38 @@ void initQueue(lnQueue_t* queue)
  */
 bool isQueueEmpty(lnQueue_t* queue)
 {
-    return (queue->numEntries == 0);
+    return (queue->head == queue->tail);
 }
 
 /**
  * check if the queue is full
  * @param q: name of the queue (pass the address of the queue)
  * @return true: if queue is full, false; if queue is not full
- */bool isQueueFull(lnQueue_t* queue)
+ */
+bool isQueueFull(lnQueue_t* queue)
+{
+    return (getQueueCount(queue) == QUEUE_SIZE);
+}
+
+/**
+ * get the number of values on the queue
+ * @param queue: name of the queue (pass the address of the queue)
+ * @return the number of values
+ */
+uint8_t getQueueCount(lnQueue_t* queue)
+{
+    return (uint8_t)(queue->tail - queue->head);
+}
+
+/**
+ * get a value from the queue without removing it
+ * @param queue: name of the queue (pass the address of the queue)
+ * @param offset: position of the value, counted from the head
+ * @return the value
+ */
+uint8_t peekQueue(lnQueue_t* queue, uint8_t offset)
 {
-    return (queue->numEntries == queue->size);
+    return queue->values[(uint8_t)(queue->head + offset) & QUEUE_MASK];
 }
 
 /**
@@ -52,14 +78,19 @@ bool enQueue(lnQueue_t* queue, uint8_t value)
     if (isQueueFull(queue))
     {
        // return false if queue is full
+       queue->overflows++;
        return false;
     }
     else
     {
         // put the value to the queue and return true
-        queue->values[queue->tail] = value;
-        queue->numEntries++;
-        queue->tail = (queue->tail + 1) % queue->size;
+        // (the tail is moved after the value is written)
+        queue->values[queue->tail & QUEUE_MASK] = value;
+        queue->tail++;
+        if (getQueueCount(queue) > queue->peak)
+        {
+            queue->peak = getQueueCount(queue);
+        }
         return true;
     }
 }
@@ -80,37 +111,164 @@ bool deQueue(lnQueue_t* queue)
     else
     {
         // set the values and return true
-        queue->head = (queue->head + 1) % queue->size;
-        queue->numEntries--;
+        queue->head++;
         return true;
     }
 }
 
 /**
- * clear the content of the queue
+ * clear the content of the queue (only to be used by the consumer)
  * @param lnQueue: name of the queue (pass the address of the queue)
  */
 void clearQueue(lnQueue_t* lnQueue)
 {
-    while (!isQueueEmpty(lnQueue))
+    lnQueue->head = lnQueue->tail;
+}
+
+/**
+ * initialise the frame queue
+ * @param queue: name of the frame queue (pass the address of the queue)
+ */
+void initFrameQueue(lnFrameQueue_t* queue)
+{
+    queue->head = 0;
+    queue->tail = 0;
+    queue->offset = 0;
+    queue->peak = 0;
+    initQueue(&queue->data);
+}
+
+/**
+ * check if the frame queue is empty
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @return true: if there is no LN message in the frame queue
+ */
+bool isFrameQueueEmpty(lnFrameQueue_t* queue)
+{
+    return (queue->head == queue->tail);
+}
+
+/**
+ * check if all descriptors of the frame queue are in use
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @return true: if no LN message can be added
+ */
+bool isFrameQueueFull(lnFrameQueue_t* queue)
+{
+    return (getFrameCount(queue) == FRAME_QUEUE_SIZE);
+}
+
+/**
+ * check if the frame queue has room for a LN message
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @param length: the length of the LN message
+ * @return true: if a descriptor and room for all bytes are free
+ */
+bool isFrameQueueRoom(lnFrameQueue_t* queue, uint8_t length)
+{
+    return (!isFrameQueueFull(queue) &&
+            (QUEUE_SIZE - getQueueCount(&queue->data) >= length));
+}
+
+/**
+ * get the number of LN messages in the frame queue
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @return the number of LN messages
+ */
+uint8_t getFrameCount(lnFrameQueue_t* queue)
+{
+    return (uint8_t)(queue->tail - queue->head);
+}
+
+/**
+ * get the length of the first LN message in the frame queue
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @return the length of the LN message
+ */
+uint8_t getFrameLength(lnFrameQueue_t* queue)
+{
+    return queue->frames[queue->head & FRAME_QUEUE_MASK].length;
+}
+
+/**
+ * get a byte of the first LN message in the frame queue
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @param index: position of the byte in the LN message
+ * @return the byte
+ */
+uint8_t peekFrame(lnFrameQueue_t* queue, uint8_t index)
+{
+    uint8_t offset = queue->frames[queue->head & FRAME_QUEUE_MASK].offset;
+    return queue->data.values[(uint8_t)(offset + index) & QUEUE_MASK];
+}
+
+/**
+ * reserve room for a new LN message (producer)
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @param length: the length of the LN message
+ * @return true: if the LN message can be written, false: if the frame queue
+ *         has no room for the complete LN message
+ */
+bool beginFrame(lnFrameQueue_t* queue, uint8_t length)
+{
+    if (!isFrameQueueRoom(queue, length))
     {
-        deQueue(lnQueue);
+        queue->data.overflows++;
+        return false;
     }
+    queue->offset = queue->data.tail;
+    return true;
 }
 
 /**
- * recover the LN message by setting the head to the begin of the LN message
- * @param lnQueue: name of the queue (pass the address of the queue)
+ * write the next byte of the new LN message (producer)
+ * the room is reserved by beginFrame
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @param value: the byte
  */
-void recoverLnMessage(lnQueue_t* lnQueue)
+void putFrame(lnFrameQueue_t* queue, uint8_t value)
 {
-    if (!isQueueEmpty(lnQueue))
+    enQueue(&queue->data, value);
+}
+
+/**
+ * make the new LN message visible for the consumer (producer)
+ * @param queue: name of the frame queue (pass the address of the queue)
+ */
+void commitFrame(lnFrameQueue_t* queue)
+{
+    lnFrame_t* frame = &queue->frames[queue->tail & FRAME_QUEUE_MASK];
+    frame->offset = queue->offset;
+    frame->length = (uint8_t)(queue->data.tail - queue->offset);
+    // the tail is moved after the descriptor is written
+    queue->tail++;
+    if (getFrameCount(queue) > queue->peak)
     {
-        // rewind head to the begin of the LN message
-        while ((lnQueue->values[lnQueue->head] & 0x80) != 0x80)
-        {
-            lnQueue->head = (lnQueue->head - 1) % lnQueue->size;
-            lnQueue->numEntries++;
-        }        
+        queue->peak = getFrameCount(queue);
+    }
+}
+
+/**
+ * drop the new LN message, the written bytes are released (producer)
+ * @param queue: name of the frame queue (pass the address of the queue)
+ */
+void abortFrame(lnFrameQueue_t* queue)
+{
+    queue->data.tail = queue->offset;
+}
+
+/**
+ * remove the first LN message from the frame queue (consumer)
+ * @param queue: name of the frame queue (pass the address of the queue)
+ * @return true: if a LN message is removed, false: if the queue is empty
+ */
+bool deQueueFrame(lnFrameQueue_t* queue)
+{
+    if (isFrameQueueEmpty(queue))
+    {
+        return false;
     }
+    queue->data.head += getFrameLength(queue);
+    queue->head++;
+    return true;
 }
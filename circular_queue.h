@@ -5,6 +5,10 @@
  *
  * revision history:
  *  v1.0 Creation (14/01/2024)
+ *  v1.1 Lock-free single producer / single consumer queue (16/10/2026)
+ *  v1.2 Frame queue (LN messages with a descriptor table) (16/10/2026)
+ *  v1.3 Abort of a LN message being written (abortFrame) (16/10/2026)
+ *  v1.4 Overflow counter and high-water mark (16/10/2026)
  */
 
 #ifndef CIRCULAR_QUEUE_H
@@ -13,24 +17,80 @@
 #include "config.h"
 
 // 128 bytes is the theoretical maximum length of a LN message
+// the size must be a power of 2 (max. 128), so the index in the values can
+// be masked (instead of a software division for a modulo)
 #define QUEUE_SIZE 128
+#define QUEUE_MASK (QUEUE_SIZE - 1)
 
+#if ((QUEUE_SIZE & QUEUE_MASK) != 0) || (QUEUE_SIZE > 128)
+#error "QUEUE_SIZE must be a power of 2 (max. 128)"
+#endif
+
+// the queue has one producer (enQueue) and one consumer (deQueue)
+// head and tail are free running 8 bit counters (the number of entries is
+// tail - head), the head is only changed by the consumer and the tail is
+// only changed by the producer, so an ISR and the main loop can share a
+// queue without disabling the interrupts
 typedef struct lnQueue_t
 {
-    uint8_t head;
-    uint8_t tail;
-    uint8_t numEntries;
-    uint8_t size;
+    volatile uint8_t head;
+    volatile uint8_t tail;
+    uint8_t peak;                   // high-water mark (producer)
+    uint8_t overflows;              // number of rejected values (producer)
     uint8_t values[QUEUE_SIZE];
 } lnQueue_t;
 
+// the number of LN messages (frames) in a frame queue
+// the size must be a power of 2 (max. 128), idem as the queue size
+#define FRAME_QUEUE_SIZE 16
+#define FRAME_QUEUE_MASK (FRAME_QUEUE_SIZE - 1)
+
+#if ((FRAME_QUEUE_SIZE & FRAME_QUEUE_MASK) != 0) || (FRAME_QUEUE_SIZE > 128)
+#error "FRAME_QUEUE_SIZE must be a power of 2 (max. 128)"
+#endif
+
+// descriptor of a LN message in a frame queue
+typedef struct lnFrame_t
+{
+    uint8_t offset;                 // index of the first byte in the values
+    uint8_t length;                 // number of bytes of the LN message
+} lnFrame_t;
+
+// the frame queue keeps complete LN messages: the bytes are in the queue
+// 'data' and every LN message has a descriptor (offset, length)
+// a LN message is only visible for the consumer after commitFrame, so the
+// consumer never sees a truncated LN message
+typedef struct lnFrameQueue_t
+{
+    volatile uint8_t head;          // first descriptor (consumer)
+    volatile uint8_t tail;          // next free descriptor (producer)
+    uint8_t offset;                 // begin of the frame being written (producer)
+    uint8_t peak;                   // high-water mark of the LN messages
+    lnFrame_t frames[FRAME_QUEUE_SIZE];
+    lnQueue_t data;
+} lnFrameQueue_t;
+
 void initQueue(lnQueue_t*);
 bool isQueueEmpty(lnQueue_t*);
 bool isQueueFull(lnQueue_t*);
+uint8_t getQueueCount(lnQueue_t*);
+uint8_t peekQueue(lnQueue_t*, uint8_t);
 bool enQueue(lnQueue_t*, uint8_t);
 bool deQueue(lnQueue_t*);
 void clearQueue(lnQueue_t*);
-void recoverLnMessage(lnQueue_t*);
+
+void initFrameQueue(lnFrameQueue_t*);
+bool isFrameQueueEmpty(lnFrameQueue_t*);
+bool isFrameQueueFull(lnFrameQueue_t*);
+bool isFrameQueueRoom(lnFrameQueue_t*, uint8_t);
+uint8_t getFrameCount(lnFrameQueue_t*);
+uint8_t getFrameLength(lnFrameQueue_t*);
+uint8_t peekFrame(lnFrameQueue_t*, uint8_t);
+bool beginFrame(lnFrameQueue_t*, uint8_t);
+void putFrame(lnFrameQueue_t*, uint8_t);
+void commitFrame(lnFrameQueue_t*);
+void abortFrame(lnFrameQueue_t*);
+bool deQueueFrame(lnFrameQueue_t*);
 
 #endif	/* CIRCULAR_QUEUE_H */
 
@@ -0,0 +1,238 @@
+/*
+ * file: config.h (host)
+ * author: J. van Hooydonk
+ * comments: replacement of the project config.h for a host (Linux) build
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Servo ISR probe pin (RE2) (16/10/2026)
+ *  v1.2 Data EEPROM registers (16/10/2026)
+ *  v1.3 NVMCON1 byte register (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef CONFIG_H
+#define	CONFIG_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef LN_HOST
+#define LN_HOST
+#endif
+
+// XC8 compiler keywords and builtins
+#define __interrupt(priority)
+#define NOP()
+#define __delay_ms(x)
+#define __delay_us(x)
+#define _XTAL_FREQ 64000000UL
+
+// the special function registers (SFR) used by the drivers
+// all bit fields are gathered in one (generic) bit register type, so every
+// XXXbits register accepts each bit name that is used in the project
+// the registers with a side effect (RC1REG, TX1REG, timer 1, line state)
+// are not accessed directly by the LN driver, refer to ln_hal_host.h
+typedef struct
+{
+    unsigned ANSELA3 :1;
+    unsigned ANSELC6 :1;
+    unsigned ANSELC7 :1;
+    unsigned TRISA3 :1;
+    unsigned TRISA4 :1;
+    unsigned TRISA5 :1;
+    unsigned TRISC4 :1;
+    unsigned TRISC5 :1;
+    unsigned TRISC6 :1;
+    unsigned TRISC7 :1;
+    unsigned TRISE0 :1;
+    unsigned TRISE1 :1;
+    unsigned TRISE2 :1;
+    unsigned LATA5 :1;
+    unsigned LATC4 :1;
+    unsigned LATC5 :1;
+    unsigned LATE0 :1;
+    unsigned LATE1 :1;
+    unsigned LATE2 :1;
+    unsigned RC6 :1;
+    unsigned RC7 :1;
+    unsigned SLRA4 :1;
+    unsigned FVREN :1;
+    unsigned FVRRDY :1;
+    unsigned EN :1;
+    unsigned ON :1;
+    unsigned SCKP :1;
+    unsigned BRG16 :1;
+    unsigned RCIDL :1;
+    unsigned SYNC :1;
+    unsigned BRGH :1;
+    unsigned TXEN :1;
+    unsigned CREN :1;
+    unsigned SPEN :1;
+    unsigned FERR :1;
+    unsigned TMR1ON :1;
+    unsigned IPEN :1;
+    unsigned GIEH :1;
+    unsigned GIEL :1;
+    unsigned RC1IP :1;
+    unsigned RC1IE :1;
+    unsigned RC1IF :1;
+    unsigned TMR1IP :1;
+    unsigned TMR1IE :1;
+    unsigned TMR1IF :1;
+    unsigned TMR3IP :1;
+    unsigned TMR3IE :1;
+    unsigned TMR3IF :1;
+    unsigned CCP1IP :1;
+    unsigned CCP1IE :1;
+    unsigned CCP1IF :1;
+    unsigned WREN :1;
+    unsigned WR :1;
+    unsigned RD :1;
+    unsigned C1TSEL :2;
+    unsigned MODE :4;
+} hostSfrBits_t;
+
+typedef struct
+{
+    // bit registers
+    hostSfrBits_t ANSELAbits;
+    hostSfrBits_t ANSELCbits;
+    hostSfrBits_t TRISAbits;
+    hostSfrBits_t TRISCbits;
+    hostSfrBits_t TRISEbits;
+    hostSfrBits_t LATAbits;
+    hostSfrBits_t LATCbits;
+    hostSfrBits_t LATEbits;
+    hostSfrBits_t PORTCbits;
+    hostSfrBits_t SLRCONAbits;
+    hostSfrBits_t FVRCONbits;
+    hostSfrBits_t CM1CON0bits;
+    hostSfrBits_t BAUD1CONbits;
+    hostSfrBits_t TX1STAbits;
+    hostSfrBits_t RC1STAbits;
+    hostSfrBits_t T1CONbits;
+    hostSfrBits_t T3CONbits;
+    hostSfrBits_t INTCONbits;
+    hostSfrBits_t IPR3bits;
+    hostSfrBits_t IPR4bits;
+    hostSfrBits_t IPR6bits;
+    hostSfrBits_t PIE3bits;
+    hostSfrBits_t PIE4bits;
+    hostSfrBits_t PIE6bits;
+    hostSfrBits_t PIR3bits;
+    hostSfrBits_t PIR4bits;
+    hostSfrBits_t PIR6bits;
+    hostSfrBits_t CCPTMRSbits;
+    hostSfrBits_t CCP1CONbits;
+    hostSfrBits_t NVMCON1bits;
+    // byte registers
+    uint8_t FVRCON;
+    uint8_t CM1NCH;
+    uint8_t CM1PCH;
+    uint8_t RA4PPS;
+    uint8_t RC6PPS;
+    uint8_t RX1PPS;
+    uint8_t SP1BRG;
+    uint8_t TMR1H;
+    uint8_t TMR1L;
+    uint8_t TMR1CLK;
+    uint8_t T1CON;
+    uint8_t TMR3CLK;
+    uint8_t T3CON;
+    uint8_t PORTA;
+    uint8_t PORTB;
+    uint8_t PORTC;
+    uint8_t TRISA;
+    uint8_t TRISB;
+    uint8_t TRISC;
+    uint8_t TRISD;
+    uint8_t ANSELA;
+    uint8_t ANSELB;
+    uint8_t ANSELC;
+    uint8_t WPUA;
+    uint8_t WPUB;
+    uint8_t WPUC;
+    uint8_t LATD;
+    uint8_t NVMCON1;
+    uint8_t NVMCON2;
+    uint8_t NVMADRL;
+    uint8_t NVMADRH;
+    uint8_t NVMDAT;
+    // word registers
+    uint16_t CCPR1;
+    uint16_t TMR3;
+} hostSfr_t;
+
+extern hostSfr_t hostSfr;
+
+#define ANSELAbits hostSfr.ANSELAbits
+#define ANSELCbits hostSfr.ANSELCbits
+#define TRISAbits hostSfr.TRISAbits
+#define TRISCbits hostSfr.TRISCbits
+#define TRISEbits hostSfr.TRISEbits
+#define LATAbits hostSfr.LATAbits
+#define LATCbits hostSfr.LATCbits
+#define LATEbits hostSfr.LATEbits
+#define PORTCbits hostSfr.PORTCbits
+#define SLRCONAbits hostSfr.SLRCONAbits
+#define FVRCONbits hostSfr.FVRCONbits
+#define CM1CON0bits hostSfr.CM1CON0bits
+#define BAUD1CONbits hostSfr.BAUD1CONbits
+#define TX1STAbits hostSfr.TX1STAbits
+#define RC1STAbits hostSfr.RC1STAbits
+#define T1CONbits hostSfr.T1CONbits
+#define T3CONbits hostSfr.T3CONbits
+#define INTCONbits hostSfr.INTCONbits
+#define IPR3bits hostSfr.IPR3bits
+#define IPR4bits hostSfr.IPR4bits
+#define IPR6bits hostSfr.IPR6bits
+#define PIE3bits hostSfr.PIE3bits
+#define PIE4bits hostSfr.PIE4bits
+#define PIE6bits hostSfr.PIE6bits
+#define PIR3bits hostSfr.PIR3bits
+#define PIR4bits hostSfr.PIR4bits
+#define PIR6bits hostSfr.PIR6bits
+#define CCPTMRSbits hostSfr.CCPTMRSbits
+#define CCP1CONbits hostSfr.CCP1CONbits
+#define NVMCON1bits hostSfr.NVMCON1bits
+#define FVRCON hostSfr.FVRCON
+#define CM1NCH hostSfr.CM1NCH
+#define CM1PCH hostSfr.CM1PCH
+#define RA4PPS hostSfr.RA4PPS
+#define RC6PPS hostSfr.RC6PPS
+#define RX1PPS hostSfr.RX1PPS
+#define SP1BRG hostSfr.SP1BRG
+#define TMR1H hostSfr.TMR1H
+#define TMR1L hostSfr.TMR1L
+#define TMR1CLK hostSfr.TMR1CLK
+#define T1CON hostSfr.T1CON
+#define TMR3CLK hostSfr.TMR3CLK
+#define T3CON hostSfr.T3CON
+#define PORTA hostSfr.PORTA
+#define PORTB hostSfr.PORTB
+#define PORTC hostSfr.PORTC
+#define TRISA hostSfr.TRISA
+#define TRISB hostSfr.TRISB
+#define TRISC hostSfr.TRISC
+#define TRISD hostSfr.TRISD
+#define ANSELA hostSfr.ANSELA
+#define ANSELB hostSfr.ANSELB
+#define ANSELC hostSfr.ANSELC
+#define WPUA hostSfr.WPUA
+#define WPUB hostSfr.WPUB
+#define WPUC hostSfr.WPUC
+#define LATD hostSfr.LATD
+#define NVMCON1 hostSfr.NVMCON1
+#define NVMCON2 hostSfr.NVMCON2
+#define NVMADRL hostSfr.NVMADRL
+#define NVMADRH hostSfr.NVMADRH
+#define NVMDAT hostSfr.NVMDAT
+#define CCPR1 hostSfr.CCPR1
+
+#define WRITETIMER3(x) (hostSfr.TMR3 = (uint16_t)(x))
+
+#endif	/* CONFIG_H */
+
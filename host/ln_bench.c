@@ -0,0 +1,94 @@
+/*
+ * file: ln_bench.c
+ * author: J. van Hooydonk
+ * comments: LocoNet driver, host benchmark of the driver (one node)
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ln.h"
+
+// declarations routines and variables
+void lnRxMessageHandler(lnFrameQueue_t*);
+static double getHostTime(void);
+
+/**
+ * main (start of program)
+ * usage: ln_bench [number of messages] [message length]
+ */
+int main(int argc, char* argv[])
+{
+    uint32_t messages = (argc > 1) ? (uint32_t)atol(argv[1]) : 10000U;
+    uint8_t length = (argc > 2) ? (uint8_t)atoi(argv[2]) : 4U;
+    if (length != 2 && length != 4 && length != 6) { length = 4; }
+
+    // one node on the LN line (the node receives his own echo, so every
+    // message is checked byte per byte by the echo compare in lnIsrRc)
+    hostLnInit(1);
+    hostLnSelect(0);
+    lnInit(&lnRxMessageHandler);
+
+    double start = getHostTime();
+    uint32_t sent = 0;
+    while (sent < messages)
+    {
+        // offer a new message as soon as the TX queue has room for it
+        if (isFrameQueueRoom(&lnTxQueue[LN_TX_PRIORITY_NORMAL], length))
+        {
+            // opcode with the message length (2, 4 or 6 bytes)
+            uint8_t lnTxMsg[6];
+            lnTxMsg[0] = (length <= 2) ? 0x83 : (length <= 4) ? 0xb1 : 0xd0;
+            for (uint8_t i = 1; i < length - 1; i++)
+            {
+                lnTxMsg[i] = (uint8_t)((sent + i) & 0x7f);
+            }
+            lnTxSend(lnTxMsg, length - 1);
+            hostLnService();
+            sent++;
+        }
+        hostLnRun(hostTime + HOST_LN_BYTE);
+        hostLnSelect(0);
+    }
+    // let the last messages go on the line
+    for (uint8_t i = 0; i < 100 && isLnTxPending(); i++)
+    {
+        hostLnRun(hostTime + 100000U);
+        hostLnSelect(0);
+    }
+    double elapsed = getHostTime() - start;
+
+    bool done = !isLnTxPending();
+    printf("messages sent      : %u%s\n", sent, done ? "" : " (not completed)");
+    printf("virtual time       : %.3f s\n", hostTime / 2e6);
+    printf("bus time / message : %.1f us\n", hostTime / 2.0 / sent);
+    printf("ISR calls          : %u\n", hostLnIsrCount);
+    printf("host time / ISR    : %.1f ns\n", elapsed * 1e9 / hostLnIsrCount);
+    return done ? 0 : 1;
+}
+
+/**
+ * this is the callback function for the LN receiver
+ * @param lnRxMsg: the LN message (frame) queue
+ */
+void lnRxMessageHandler(lnFrameQueue_t* lnRxMsg)
+{
+    while (deQueueFrame(lnRxMsg));
+}
+
+/**
+ * get the (monotonic) time of the host
+ * @return the time in seconds
+ */
+static double getHostTime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
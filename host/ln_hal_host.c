@@ -0,0 +1,432 @@
+/*
+ * file: ln_hal_host.c
+ * author: J. van Hooydonk
+ * comments: LocoNet driver, virtual-time register shim for a host build
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Main loop of the node (lnPoll) after the ISR (16/10/2026)
+ *  v1.2 Unique ID of the nodes (16/10/2026)
+ *  v1.3 Size check of the driver variables of a node (16/10/2026)
+ */
+
+#include <string.h>
+#include "ln.h"
+
+// the register names are macros to the register file of the selected node
+// (refer to config.h), but the virtual hardware needs the registers of all
+// nodes, so these registers are always accessed through a hostSfr_t
+#undef FVRCONbits
+#undef PORTCbits
+#undef BAUD1CONbits
+#undef RC1STAbits
+#undef T1CONbits
+#undef INTCONbits
+#undef PIE3bits
+#undef PIE4bits
+#undef PIR3bits
+#undef PIR4bits
+#undef PORTA
+#undef PORTB
+#undef PORTC
+
+// <editor-fold defaultstate="collapsed" desc="variables">
+
+// the register file of the selected node
+hostSfr_t hostSfr;
+
+hostLnLineStats_t hostLnLineStats;
+uint32_t hostTime;
+uint8_t hostLnNode;
+uint32_t hostLnIsrCount;
+
+// the variables of the LN driver (ln.h) are global, so every node keeps its
+// own copy and the copy is swapped in when the node is selected
+// keep this list in line with the variables in ln.h
+#define HOST_LN_VARIABLES(X) \
+    X(LNCON) \
+    X(lnRxMsgCallback) \
+    X(lnTxSpaceCallback) \
+    X(lnTxWaitLength) \
+    X(lastRandomValue) \
+    X(lnBackoffBits) \
+    X(lnTxIndex) \
+    X(lnTxPriority) \
+    X(lnTxSequence) \
+    X(lnTxStamp) \
+    X(lnTxClassStats) \
+    X(lnTxQueue) \
+    X(lnRxQueue) \
+    X(lnRxLength) \
+    X(lnRxCount) \
+    X(lnRxChecksum) \
+    X(lnRxSw1) \
+    X(lnRxFilter) \
+    X(lnStats)
+#define HOST_LN_VARIABLE(name) { &name, sizeof(name) },
+#define HOST_LN_VARIABLE_SIZE(name) sizeof(name) +
+
+typedef struct
+{
+    void* address;
+    size_t size;
+} hostLnVariable_t;
+
+static const hostLnVariable_t hostLnVariables[] =
+{
+    HOST_LN_VARIABLES(HOST_LN_VARIABLE)
+};
+
+// the copy of the variables must fit in the state of a node (hostLnSwap),
+// a negative array size stops the build otherwise
+typedef char hostLnStateSizeCheck_t[
+        ((HOST_LN_VARIABLES(HOST_LN_VARIABLE_SIZE) 0) <= HOST_LN_STATE_SIZE) ?
+        1 : -1];
+
+// virtual hardware of a node
+typedef struct
+{
+    hostSfr_t sfr;                  // register file (when not selected)
+    uint8_t state[HOST_LN_STATE_SIZE]; // LN driver variables (idem)
+    uint32_t tmr1Overflow;          // time of the next timer 1 overflow
+    int32_t clockPpm;               // clock error of the node (ppm)
+    uint8_t rxData;                 // received byte (RC1REG)
+    bool linebreak;                 // node holds the line low (TX pin)
+} hostLnDevice_t;
+
+static hostLnDevice_t hostLnDevices[HOST_LN_MAX_NODES];
+static uint8_t hostLnNodes;
+
+// the virtual LN line (wired AND of all transmitters)
+// a byte on the line is kept as a 10 bit frame word: bit 0 = start bit,
+// bit 1 - 8 = data (lsb first), bit 9 = stop bit
+typedef struct
+{
+    bool active;                    // a byte is on the line
+    uint32_t start;                 // begin of the first start bit
+    uint32_t end;                   // end of the last stop bit
+    uint16_t word;                  // frame word seen by the receivers
+    uint8_t transmitters;           // number of nodes that transmit
+} hostLnLine_t;
+
+static hostLnLine_t hostLnLine;
+static uint8_t hostLnLinebreaks;    // number of nodes holding a linebreak
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="node routines">
+
+/**
+ * save or restore the LN driver variables of a node
+ * @param node: index of the node
+ * @param save: true = save the variables, false = restore the variables
+ */
+static void hostLnSwap(uint8_t node, bool save)
+{
+    uint8_t* state = hostLnDevices[node].state;
+
+    for (size_t i = 0; i < sizeof(hostLnVariables) / sizeof(hostLnVariables[0]); i++)
+    {
+        if (save)
+        {
+            memcpy(state, hostLnVariables[i].address, hostLnVariables[i].size);
+        }
+        else
+        {
+            memcpy(hostLnVariables[i].address, state, hostLnVariables[i].size);
+        }
+        state += hostLnVariables[i].size;
+    }
+    if (save)
+    {
+        hostLnDevices[node].sfr = hostSfr;
+    }
+    else
+    {
+        hostSfr = hostLnDevices[node].sfr;
+    }
+}
+
+/**
+ * get the register file of a node
+ * @param node: index of the node
+ * @return pointer to the register file
+ */
+static hostSfr_t* hostLnSfr(uint8_t node)
+{
+    return (node == hostLnNode) ? &hostSfr : &hostLnDevices[node].sfr;
+}
+
+/**
+ * initialise the virtual hardware
+ * @param nodes: the number of nodes on the LN line
+ */
+void hostLnInit(uint8_t nodes)
+{
+    memset(hostLnDevices, 0, sizeof(hostLnDevices));
+    memset(&hostLnLine, 0, sizeof(hostLnLine));
+    memset(&hostLnLineStats, 0, sizeof(hostLnLineStats));
+    hostLnNodes = (nodes > HOST_LN_MAX_NODES) ? HOST_LN_MAX_NODES : nodes;
+    hostLnLinebreaks = 0;
+    hostLnIsrCount = 0;
+    hostTime = 0;
+
+    for (uint8_t i = 0; i < hostLnNodes; i++)
+    {
+        // power on state of the registers that are polled by the drivers
+        hostLnDevices[i].sfr.FVRCONbits.FVRRDY = true;
+        hostLnDevices[i].sfr.PORTCbits.RC7 = true;
+        hostLnDevices[i].sfr.BAUD1CONbits.RCIDL = true;
+        hostLnDevices[i].tmr1Overflow = 0x10000UL;
+        hostLnDevices[i].clockPpm = (nodes > 1) ?
+                -HOST_LN_CLOCK_PPM + (2 * HOST_LN_CLOCK_PPM * i) / (nodes - 1) : 0;
+        hostLnDevices[i].sfr.PORTA = 0xff;
+        hostLnDevices[i].sfr.PORTB = 0xff;
+        hostLnDevices[i].sfr.PORTC = 0xff;
+    }
+    hostLnNode = 0;
+    hostSfr = hostLnDevices[0].sfr;
+}
+
+/**
+ * select a node (the LN driver variables are those of this node)
+ * @param node: index of the node
+ */
+void hostLnSelect(uint8_t node)
+{
+    if (node != hostLnNode)
+    {
+        hostLnSwap(hostLnNode, true);
+        hostLnNode = node;
+        hostLnSwap(hostLnNode, false);
+    }
+}
+
+/**
+ * handle all pending low priority interrupts of the selected node and run
+ * the main loop (lnPoll) of the node
+ */
+void hostLnService(void)
+{
+    while (hostSfr.INTCONbits.GIEL &&
+            ((hostSfr.PIR4bits.TMR1IF && hostSfr.PIE4bits.TMR1IE) ||
+             (hostSfr.PIR3bits.RC1IF && hostSfr.PIE3bits.RC1IE)))
+    {
+        hostLnIsrCount++;
+        lnIsr();
+    }
+    // the main loop of the node runs between the interrupts
+    lnPoll();
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="virtual time">
+
+/**
+ * end of a byte on the line, deliver it to all (enabled) receivers
+ */
+static void hostLnLineEnd(void)
+{
+    uint8_t data = (uint8_t)(hostLnLine.word >> 1);
+    bool ferr = ((hostLnLine.word & 0x200U) == 0);
+
+    hostLnLine.active = false;
+    hostLnLineStats.bytes++;
+    if (hostLnLine.transmitters > 1)
+    {
+        hostLnLineStats.collisions++;
+    }
+    for (uint8_t i = 0; i < hostLnNodes; i++)
+    {
+        hostSfr_t* sfr = hostLnSfr(i);
+        if (sfr->RC1STAbits.SPEN && sfr->RC1STAbits.CREN)
+        {
+            hostLnDevices[i].rxData = data;
+            sfr->RC1STAbits.FERR = ferr;
+            sfr->PIR3bits.RC1IF = true;
+            hostLnSelect(i);
+            hostLnService();
+        }
+    }
+}
+
+/**
+ * run the virtual time till a given moment
+ * @param until: the end time (in ticks)
+ */
+void hostLnRun(uint32_t until)
+{
+    while (true)
+    {
+        // search the first event: end of a byte or a timer 1 overflow
+        uint32_t next = until;
+        int8_t node = -1;
+        bool line = false;
+
+        if (hostLnLine.active && hostLnLine.end <= next)
+        {
+            next = hostLnLine.end;
+            line = true;
+        }
+        for (uint8_t i = 0; i < hostLnNodes; i++)
+        {
+            if (hostLnSfr(i)->T1CONbits.TMR1ON &&
+                    hostLnDevices[i].tmr1Overflow < next)
+            {
+                next = hostLnDevices[i].tmr1Overflow;
+                node = (int8_t)i;
+                line = false;
+            }
+        }
+        if (!line && node < 0)
+        {
+            hostTime = until;
+            return;
+        }
+        hostTime = next;
+
+        if (line)
+        {
+            hostLnLineEnd();
+        }
+        else
+        {
+            // timer 1 overflow, the timer continues from 0x0000
+            hostLnDevices[node].tmr1Overflow += 0x10000UL;
+            hostLnSfr((uint8_t)node)->PIR4bits.TMR1IF = true;
+            hostLnSelect((uint8_t)node);
+            hostLnService();
+        }
+    }
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="HAL routines">
+
+/**
+ * read RC1REG (clears the interrupt flag and the framing error)
+ * @return the received byte
+ */
+uint8_t hostLnReadRx(void)
+{
+    hostSfr.PIR3bits.RC1IF = false;
+    hostSfr.RC1STAbits.FERR = false;
+    return hostLnDevices[hostLnNode].rxData;
+}
+
+/**
+ * write TX1REG, the byte is put on the line
+ * @param data: the byte to transmit
+ */
+void hostLnWriteTx(uint8_t data)
+{
+    uint16_t word = (uint16_t)(0x200U | ((uint16_t)data << 1));
+
+    if (!hostLnLine.active)
+    {
+        hostLnLine.active = true;
+        hostLnLine.start = hostTime;
+        hostLnLine.end = hostTime;
+        hostLnLine.word = (hostLnLinebreaks > 0) ? 0x000U : 0x3ffU;
+        hostLnLine.transmitters = 0;
+    }
+    hostLnLine.transmitters++;
+    // a transmitter that starts k bits later overlaps the frame word
+    // shifted over k bits (the line is a wired AND)
+    uint32_t k = (hostTime - hostLnLine.start) / HOST_LN_BIT;
+    if (k < 10)
+    {
+        hostLnLine.word &= (uint16_t)(((uint32_t)word << k) | ((1UL << k) - 1));
+    }
+    if (hostTime + HOST_LN_BYTE > hostLnLine.end)
+    {
+        hostLnLine.end = hostTime + HOST_LN_BYTE;
+    }
+}
+
+/**
+ * drive the TX pin (true = the line is held low, i.e. a linebreak)
+ * @param value: state of the TX pin
+ */
+void hostLnSetTxPin(bool value)
+{
+    hostLnDevice_t* device = &hostLnDevices[hostLnNode];
+
+    if (value && !device->linebreak)
+    {
+        device->linebreak = true;
+        if (hostLnLinebreaks++ > 0)
+        {
+            // the line is already held low by an other node (no new edge)
+            return;
+        }
+        hostLnLineStats.linebreaks++;
+        if (hostLnLine.active)
+        {
+            // the rest of the byte on the line is zero (incl. the stop bit)
+            uint32_t k = (hostTime - hostLnLine.start) / HOST_LN_BIT;
+            hostLnLine.word &= (uint16_t)((1UL << (k < 10 ? k : 10)) - 1);
+        }
+        else
+        {
+            // the falling edge of the break is seen as a start bit
+            hostLnLine.active = true;
+            hostLnLine.start = hostTime;
+            hostLnLine.end = hostTime + HOST_LN_BYTE;
+            hostLnLine.word = 0x000U;
+            hostLnLine.transmitters = 0;
+        }
+    }
+    else if (!value && device->linebreak)
+    {
+        device->linebreak = false;
+        hostLnLinebreaks--;
+    }
+}
+
+/**
+ * check the LN line (RC7) and the receiver (RCIDL)
+ * a byte is only seen after the detection time (HOST_LN_DETECT), so nodes
+ * that check the line within this time all start to transmit (collision)
+ * @return true: if the line is idle
+ */
+bool hostLnIsLineIdle(void)
+{
+    bool busy = hostLnLine.active &&
+            (hostTime >= hostLnLine.start + HOST_LN_DETECT);
+    return (!busy && hostLnLinebreaks == 0);
+}
+
+/**
+ * write timer 1 (the timer overflows after 0x10000 - value ticks of the
+ * clock of the node)
+ * @param value: the timer value
+ */
+void hostLnWriteTmr1(uint16_t value)
+{
+    hostLnDevice_t* device = &hostLnDevices[hostLnNode];
+    int64_t ticks = 0x10000L - value;
+
+    ticks += (ticks * device->clockPpm) / 1000000L;
+    device->tmr1Overflow = hostTime + (uint32_t)ticks;
+}
+
+/**
+ * read a byte of the unique ID (MUI) of the selected node
+ * every node gets an other (but reproducible) unique ID
+ * @param index: index of the byte
+ * @return the byte of the unique ID
+ */
+uint8_t hostLnReadMui(uint8_t index)
+{
+    uint32_t x = (hostLnNode + 1UL) * 0x9e3779b9UL + index * 0x85ebca6bUL;
+
+    x ^= x >> 16;
+    x *= 0x7feb352dUL;
+    x ^= x >> 15;
+    return (uint8_t)x;
+}
+
+// </editor-fold>
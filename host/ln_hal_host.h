@@ -0,0 +1,84 @@
+/*
+ * file: ln_hal_host.h
+ * author: J. van Hooydonk
+ * comments: LocoNet driver, virtual-time register shim for a host build
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Unique ID of the nodes (16/10/2026)
+ *  v1.2 Timer 1 interrupt request (16/10/2026)
+ *  v1.3 Start and stop of timer 1 (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef LN_HAL_HOST_H
+#define	LN_HAL_HOST_H
+
+#include "config.h"
+
+// the virtual time runs in ticks of timer 1 (Fosc / 4 / 8 = 2MHz = 0.5µs)
+// one LN bit = 60µs, one LN byte = start bit + 8 data bits + stop bit
+#define HOST_LN_BIT 120U
+#define HOST_LN_BYTE (10U * HOST_LN_BIT)
+#define HOST_LN_MAX_NODES 64U
+// time between the start of a byte and the moment the other nodes see the
+// line as busy (transceiver delay + code between isLnFree and TX1REG write)
+#define HOST_LN_DETECT 20U
+// tolerance of the (internal) oscillator of the nodes, every node gets a
+// fixed clock error between -HOST_LN_CLOCK_PPM and +HOST_LN_CLOCK_PPM
+#define HOST_LN_CLOCK_PPM 5000
+// room for the copy of the driver variables (ln.h) of one node
+#define HOST_LN_STATE_SIZE 4096U
+
+// HAL of the LN driver (refer to ln_hal.h)
+#define LN_HAL_IS_TMR1_IF() (PIR4bits.TMR1IF)
+#define LN_HAL_CLEAR_TMR1_IF() (PIR4bits.TMR1IF = false)
+#define LN_HAL_SET_TMR1_IF() (PIR4bits.TMR1IF = true)
+#define LN_HAL_IS_RC_IF() (PIR3bits.RC1IF)
+#define LN_HAL_IS_FERR() (RC1STAbits.FERR)
+#define LN_HAL_READ_RX() hostLnReadRx()
+#define LN_HAL_WRITE_TX(data) hostLnWriteTx(data)
+#define LN_HAL_SET_RX_ENABLE(value) (RC1STAbits.SPEN = (value))
+#define LN_HAL_SET_TX_PIN(value) hostLnSetTxPin(value)
+#define LN_HAL_SET_BRG(value) (SP1BRG = (value))
+#define LN_HAL_RESTART_BRG() \
+    do { TX1STAbits.TXEN = false; TX1STAbits.TXEN = true; } while (0)
+#define LN_HAL_IS_LINE_IDLE() hostLnIsLineIdle()
+#define LN_HAL_WRITE_TMR1(value) hostLnWriteTmr1((uint16_t)(value))
+#define LN_HAL_SET_TMR1_ON(value) (T1CONbits.TMR1ON = (value))
+#define LN_HAL_SET_LED_LN(value) (LATAbits.LATA5 = (value))
+#define LN_HAL_SET_LED_RX(value) (LATEbits.LATE0 = (value))
+#define LN_HAL_SET_LED_TX(value) (LATEbits.LATE1 = (value))
+#define LN_HAL_READ_MUI(index, value) ((value) = hostLnReadMui(index))
+
+// shim routines (called by the LN driver through the HAL)
+uint8_t hostLnReadRx(void);
+void hostLnWriteTx(uint8_t);
+void hostLnSetTxPin(bool);
+bool hostLnIsLineIdle(void);
+void hostLnWriteTmr1(uint16_t);
+uint8_t hostLnReadMui(uint8_t);
+
+// host routines (called by the host program)
+void hostLnInit(uint8_t);
+void hostLnSelect(uint8_t);
+void hostLnService(void);
+void hostLnRun(uint32_t);
+
+// statistics of the virtual LN line
+typedef struct
+{
+    uint32_t bytes;                 // bytes on the line
+    uint32_t collisions;            // bytes with more than one transmitter
+    uint32_t linebreaks;            // linebreaks on the line
+} hostLnLineStats_t;
+
+// host variables
+extern hostLnLineStats_t hostLnLineStats;
+extern uint32_t hostTime;           // virtual time (in ticks of 0.5µs)
+extern uint8_t hostLnNode;          // node that is currently selected
+extern uint32_t hostLnIsrCount;     // number of calls to lnIsr
+
+#endif	/* LN_HAL_HOST_H */
+
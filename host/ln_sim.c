@@ -0,0 +1,241 @@
+/*
+ * file: ln_sim.c
+ * author: J. van Hooydonk
+ * comments: LocoNet driver, host simulation of N nodes on one LN line
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Power-up burst (load 0) (16/10/2026)
+ *  v1.2 Message number (14 bits) within the last offered messages (16/10/2026)
+ *  v1.3 Delivered messages per second within the load step (16/10/2026)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "ln.h"
+
+// definitions
+#define SIM_MAX_MESSAGES 200000U
+#define SIM_TICKS_PER_S 2000000UL   // virtual time: 1 tick = 0.5µs
+#define SIM_DRAIN 1000000UL         // time to empty the queues at the end
+#define SIM_ID_RANGE 16384U         // message number in the LN message (14 bits)
+
+// declarations routines and variables
+void lnRxMessageHandler(lnFrameQueue_t*);
+static void simRun(uint8_t, double, double);
+static void simSend(uint8_t);
+static double simRandom(void);
+static int simCompare(const void*, const void*);
+
+static uint32_t simEnqueueTime[SIM_MAX_MESSAGES];
+static bool simDelivered[SIM_MAX_MESSAGES];
+static uint32_t simLatency[SIM_MAX_MESSAGES];
+static uint32_t simMessages;        // number of offered messages
+static uint32_t simRejected;        // number of messages not queued (full)
+static uint32_t simWindowDeliveries;// delivered messages within the window
+static uint32_t simWindowEnd;       // end of the load step (window)
+static uint64_t simSeed = 0x2545f4914f6cdd1dULL;
+
+/**
+ * main (start of program)
+ * usage: ln_sim [nodes] [seconds per load step] [load 1] [load 2] ...
+ *        a load is the total offered load in messages per second
+ *        load 0 is a power-up burst: all nodes offer one message at the
+ *        same moment (e.g. the reports after a global power ON)
+ */
+int main(int argc, char* argv[])
+{
+    static const double loads[] = { 10, 25, 50, 75, 100, 125, 150, 175, 200 };
+    uint8_t nodes = (argc > 1) ? (uint8_t)atoi(argv[1]) : 16U;
+    double seconds = (argc > 2) ? atof(argv[2]) : 20.0;
+
+    if (nodes < 2) { nodes = 2; }
+    if (nodes > HOST_LN_MAX_NODES) { nodes = HOST_LN_MAX_NODES; }
+
+    printf("nodes: %u, %.0f s per load step, 4 byte messages\n", nodes, seconds);
+    printf("%8s %8s %8s %8s %9s %9s %8s %8s %8s\n", "offered", "offer/s",
+            "msg/s", "rejected", "collision", "linebreak", "p50 ms", "p99 ms",
+            "p999 ms");
+    if (argc > 3)
+    {
+        for (int i = 3; i < argc; i++)
+        {
+            simRun(nodes, seconds, atof(argv[i]));
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < sizeof(loads) / sizeof(loads[0]); i++)
+        {
+            simRun(nodes, seconds, loads[i]);
+        }
+    }
+    return 0;
+}
+
+/**
+ * simulate a number of nodes with a given (total) offered load
+ * every node offers messages with exponential (Poisson) inter arrival times
+ * @param nodes: number of nodes on the LN line
+ * @param seconds: simulated time
+ * @param load: total offered load (messages per second)
+ */
+static void simRun(uint8_t nodes, double seconds, double load)
+{
+    uint32_t nextArrival[HOST_LN_MAX_NODES];
+    uint32_t end = (uint32_t)(seconds * SIM_TICKS_PER_S);
+    double mean = SIM_TICKS_PER_S * nodes / load;
+
+    simMessages = 0;
+    simRejected = 0;
+    simWindowDeliveries = 0;
+    simWindowEnd = end;
+    memset(simDelivered, 0, sizeof(simDelivered));
+
+    // all nodes are powered on at the same moment
+    hostLnInit(nodes);
+    for (uint8_t i = 0; i < nodes; i++)
+    {
+        hostLnSelect(i);
+        lnInit(&lnRxMessageHandler);
+        nextArrival[i] = (uint32_t)(-log(simRandom()) * mean);
+    }
+
+    // power-up burst: one message per node at the same moment
+    if (load <= 0)
+    {
+        for (uint8_t i = 0; i < nodes; i++)
+        {
+            hostLnSelect(i);
+            simSend(i);
+            hostLnService();
+        }
+        // the burst has no load step, all deliveries are counted
+        end = 0;
+        simWindowEnd = SIM_DRAIN;
+    }
+
+    while (load > 0)
+    {
+        // search the next node that offers a message
+        uint8_t node = 0;
+        for (uint8_t i = 1; i < nodes; i++)
+        {
+            if (nextArrival[i] < nextArrival[node]) { node = i; }
+        }
+        if (nextArrival[node] >= end || simMessages >= SIM_MAX_MESSAGES)
+        {
+            break;
+        }
+        hostLnRun(nextArrival[node]);
+        hostLnSelect(node);
+        simSend(node);
+        hostLnService();
+        nextArrival[node] += (uint32_t)(-log(simRandom()) * mean) + 1;
+    }
+    hostLnRun(end + SIM_DRAIN);
+
+    // latency percentiles of the delivered messages
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < simMessages; i++)
+    {
+        if (simDelivered[i]) { simLatency[n++] = simLatency[i]; }
+    }
+    qsort(simLatency, n, sizeof(simLatency[0]), simCompare);
+    double p50 = n ? simLatency[n / 2] / 2000.0 : 0;
+    double p99 = n ? simLatency[(n * 99) / 100] / 2000.0 : 0;
+    double p999 = n ? simLatency[(n * 999) / 1000] / 2000.0 : 0;
+
+    // the messages per second are the messages offered and delivered
+    // within the load step (the deliveries while the queues are emptied at
+    // the end are not counted), the actual offered rate (random arrivals)
+    // is given as well
+    printf("%8.0f %8.1f %8.1f %8u %8.2f%% %9u %8.2f %8.2f %8.2f\n", load,
+            (simMessages + simRejected) / seconds,
+            simWindowDeliveries / seconds, simRejected,
+            hostLnLineStats.bytes ?
+                100.0 * hostLnLineStats.collisions / hostLnLineStats.bytes : 0,
+            hostLnLineStats.linebreaks, p50, p99, p999);
+}
+
+/**
+ * offer a message on the selected node
+ * the message is a 4 byte message (0xA0 class) with a unique number
+ * @param node: index of the node
+ */
+static void simSend(uint8_t node)
+{
+    uint32_t id = simMessages;
+
+    // the node only queues the message if the TX queue has room for it
+    if (!isFrameQueueRoom(&lnTxQueue[LN_TX_PRIORITY_NORMAL], 4))
+    {
+        simRejected++;
+        return;
+    }
+    simEnqueueTime[id] = hostTime;
+    simMessages++;
+    uint8_t lnTxMsg[3];
+    lnTxMsg[0] = 0xa0 | (node & 0x1f);
+    lnTxMsg[1] = (uint8_t)(id & 0x7f);
+    lnTxMsg[2] = (uint8_t)((id >> 7) & 0x7f);
+    lnTxSend(lnTxMsg, sizeof(lnTxMsg));
+}
+
+/**
+ * this is the callback function for the LN receiver (of all nodes)
+ * a message is delivered when the first other node receives it
+ * @param lnRxMsg: the LN message (frame) queue
+ */
+void lnRxMessageHandler(lnFrameQueue_t* lnRxMsg)
+{
+    while (!isFrameQueueEmpty(lnRxMsg))
+    {
+        uint8_t opcode = peekFrame(lnRxMsg, 0);
+        uint32_t id = peekFrame(lnRxMsg, 1);
+        id |= (uint32_t)peekFrame(lnRxMsg, 2) << 7;
+        // the LN message has only the lower 14 bits of the number, it is
+        // one of the last SIM_ID_RANGE offered messages (the TX queues are
+        // much smaller than this range)
+        uint32_t base = (simMessages > SIM_ID_RANGE) ?
+                simMessages - SIM_ID_RANGE : 0;
+        id = base + ((id - base) & (SIM_ID_RANGE - 1));
+
+        if ((opcode & 0xe0) == 0xa0 && id < simMessages && !simDelivered[id])
+        {
+            simDelivered[id] = true;
+            simLatency[id] = hostTime - simEnqueueTime[id];
+            if (hostTime < simWindowEnd)
+            {
+                simWindowDeliveries++;
+            }
+        }
+        deQueueFrame(lnRxMsg);
+    }
+}
+
+/**
+ * random generator (xorshift64*)
+ * @return a random value in ]0, 1[
+ */
+static double simRandom(void)
+{
+    simSeed ^= simSeed >> 12;
+    simSeed ^= simSeed << 25;
+    simSeed ^= simSeed >> 27;
+    return ((simSeed * 0x2545f4914f6cdd1dULL) >> 11) * (1.0 / 9007199254740992.0) +
+            (0.5 / 9007199254740992.0);
+}
+
+/**
+ * compare routine for qsort
+ */
+static int simCompare(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
@@ -0,0 +1,276 @@
+/*
+ * file: nvm_trace.c
+ * author: J. van Hooydonk
+ * comments: AW driver, host trace of the AW status in the data EEPROM
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Corrupted record (CRC-8) (16/10/2026)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "aw.h"
+
+// definitions
+// a write of the data EEPROM takes a few ms, so the model is busy for one
+// call after every write (the next byte of a record is one frame later)
+#define TRACE_WRITE_BUSY 1U
+// number of status changes of the ring test (more than one lap)
+#define TRACE_CHANGES 100U
+
+// declarations routines and variables
+static void traceHandler(uint8_t);
+static void traceBoot(void);
+static void traceFrames(uint32_t);
+static void traceCommand(uint8_t, bool);
+static void traceCheck(bool, const char*);
+static uint32_t traceWrites(void);
+
+// the register file (refer to config.h)
+hostSfr_t hostSfr;
+
+static uint8_t traceEeprom[NVM_SIZE];   // data EEPROM (model)
+static uint32_t traceWritten[NVM_SIZE]; // writes per byte (wear)
+static uint8_t traceBusy;           // calls till the write is finished
+static int32_t traceWriteLimit = -1;// writes till the reset (-1 = none)
+static uint32_t traceReports;       // reports (AW callback)
+static uint32_t traceErrors;
+
+/**
+ * main (start of program)
+ * usage: nvm_trace
+ *        the AW status is changed with commands (0xB0), the data EEPROM is
+ *        checked after every step and the AW driver is restarted (reset)
+ *        with the content of the data EEPROM: erased EEPROM, coalescing,
+ *        restore, wrap of the ring, a record torn by a reset and a
+ *        corrupted record
+ * @return 0: all checks are passed, 1: otherwise
+ */
+int main(void)
+{
+    uint32_t writes;
+    uint8_t cawl;
+
+    // erased data EEPROM: all AW in the middle, nothing is written
+    memset(traceEeprom, 0xff, sizeof(traceEeprom));
+    traceBoot();
+    traceFrames(AW_NVM_DELAY * 2U);
+    traceCheck((AWCON.CAWL == 0) && (AWCON.CAWR == 0) && (traceWrites() == 0),
+            "erased data EEPROM");
+
+    // coalescing: the changes within the delay give one record
+    traceCommand(3, true);
+    traceFrames(AW_NVM_DELAY / 2U);
+    traceCommand(4, false);
+    traceFrames(AW_NVM_DELAY / 2U);
+    traceCommand(3, false);
+    traceFrames(AW_NVM_DELAY / 2U);
+    traceCheck(traceWrites() == 0, "no write within the delay");
+    traceFrames(AW_NVM_DELAY + AW_NVM_RECORD_SIZE * 2U);
+    traceCheck(traceWrites() == AW_NVM_RECORD_SIZE, "coalescing (one record)");
+
+    // restore: the AW are in position at once, without reports
+    traceFrames(AW_NVM_DELAY * 2U);
+    traceBoot();
+    traceCheck((AWCON.CAWR == 0x18) && (AWCON.KAWR == 0x18) &&
+            (AWCON.CAWL == 0) && (traceReports == 0), "restore (status)");
+    traceCheck((servoPortD[3] == getAwPosition(3)) &&
+            (getAwPosition(3) == SERVO_MIN) &&
+            (servoPortD[0] == getAwPosition(0)), "restore (position)");
+
+    // wrap of the ring: the last status is restored, the wear is spread
+    for (uint8_t i = 0; i < TRACE_CHANGES; i++)
+    {
+        traceCommand(i & 0x07, (i & 0x08) != 0);
+        traceFrames(AW_NVM_DELAY + AW_NVM_RECORD_SIZE * 4U);
+    }
+    writes = traceWrites();
+    cawl = AWCON.CAWL;
+    traceBoot();
+    traceCheck(AWCON.CAWL == cawl, "wrap of the ring (restore)");
+    uint32_t wear = 0;
+    for (uint16_t i = 0; i < NVM_SIZE; i++)
+    {
+        if (traceWritten[i] > wear)
+        {
+            wear = traceWritten[i];
+        }
+    }
+    traceCheck(wear <= (TRACE_CHANGES + 1U) / AW_NVM_RECORDS + 1U,
+            "wrap of the ring (wear)");
+
+    // torn record: a reset during the write of a record gives the status
+    // of the record before
+    traceCommand(7, !(cawl & 0x80));
+    traceWriteLimit = AW_NVM_RECORD_SIZE / 2U;
+    traceFrames(AW_NVM_DELAY + AW_NVM_RECORD_SIZE * 4U);
+    traceWriteLimit = -1;
+    traceBoot();
+    traceCheck(AWCON.CAWL == cawl, "torn record");
+
+    // corrupted record: two bytes of the last record swapped (a sum of the
+    // bytes is the same) gives the status of the record before
+    traceCommand(6, !(cawl & 0x40));
+    traceFrames(AW_NVM_DELAY + AW_NVM_RECORD_SIZE * 4U);
+    uint16_t address = (uint16_t)awNvm.slot * AW_NVM_RECORD_SIZE;
+    uint8_t value = traceEeprom[address + 1];
+    traceEeprom[address + 1] = traceEeprom[address + 2];
+    traceEeprom[address + 2] = value;
+    traceBoot();
+    traceCheck(AWCON.CAWL == cawl, "corrupted record");
+
+    printf("data EEPROM writes : %u (max. %u per byte)\n", writes, wear);
+    printf("errors             : %u\n", traceErrors);
+    return (traceErrors == 0) ? 0 : 1;
+}
+
+/**
+ * restart (reset) the AW driver with the content of the data EEPROM
+ */
+static void traceBoot(void)
+{
+    memset(&AWCON, 0, sizeof(AWCON));
+    memset(&awNvm, 0, sizeof(awNvm));
+    traceBusy = 0;
+    traceReports = 0;
+    PORTB = 0xff;                   // no KAW switches
+    awInit(&traceHandler);
+}
+
+/**
+ * run the AW driver for a number of frames (20ms)
+ * @param frames: the number of frames
+ */
+static void traceFrames(uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        servoFrameFlag = true;
+        servoTask();
+    }
+}
+
+/**
+ * command an AW (as the LN message 0xB0)
+ * @param index: the index of the AW
+ * @param left: true: left position, false: right position
+ */
+static void traceCommand(uint8_t index, bool left)
+{
+    uint8_t mask = (uint8_t)(1 << index);
+
+    setCAWL(mask, left ? mask : 0x00);
+    setCAWR(mask, left ? 0x00 : mask);
+}
+
+/**
+ * count a failed check
+ * @param condition: the result of the check
+ * @param name: the name of the check
+ */
+static void traceCheck(bool condition, const char* name)
+{
+    if (!condition)
+    {
+        printf("error: %s\n", name);
+        traceErrors++;
+    }
+}
+
+/**
+ * get the number of writes of the data EEPROM
+ * @return the number of writes
+ */
+static uint32_t traceWrites(void)
+{
+    uint32_t writes = 0;
+
+    for (uint16_t i = 0; i < NVM_SIZE; i++)
+    {
+        writes += traceWritten[i];
+    }
+    return writes;
+}
+
+/**
+ * this is the callback function for the AW reports (KAW changes)
+ * @param mask: the changed AW
+ */
+static void traceHandler(uint8_t mask)
+{
+    (void)mask;
+    traceReports++;
+}
+
+// <editor-fold defaultstate="collapsed" desc="data EEPROM model">
+
+// the routines of nvm.c (register access only) are replaced by the model
+
+/**
+ * read a byte of the data EEPROM
+ * @param address: the address in the data EEPROM
+ * @return the value
+ */
+uint8_t nvmRead(uint16_t address)
+{
+    return traceEeprom[address % NVM_SIZE];
+}
+
+/**
+ * start the write of a byte in the data EEPROM (non-blocking)
+ * after traceWriteLimit writes the device is in reset: the writes are lost
+ * @param address: the address in the data EEPROM
+ * @param value: the value
+ * @return true: if the write is started, false: if the data EEPROM is busy
+ */
+bool nvmWrite(uint16_t address, uint8_t value)
+{
+    if (traceBusy != 0)
+    {
+        traceBusy--;
+        return false;
+    }
+    if (traceWriteLimit == 0)
+    {
+        return true;
+    }
+    if (traceWriteLimit > 0)
+    {
+        traceWriteLimit--;
+    }
+    traceEeprom[address % NVM_SIZE] = value;
+    traceWritten[address % NVM_SIZE]++;
+    traceBusy = TRACE_WRITE_BUSY;
+    return true;
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="HAL routines">
+
+// the servo pulses are not traced (refer to servo_trace.c)
+
+void hostServoWritePort(uint8_t group, uint8_t value)
+{
+    (void)group;
+    (void)value;
+}
+
+void hostServoWriteTmr3(uint16_t value)
+{
+    (void)value;
+}
+
+uint16_t hostServoReadTmr3(void)
+{
+    return 0;
+}
+
+void hostServoWriteCcpr(uint16_t value)
+{
+    (void)value;
+}
+
+// </editor-fold>
@@ -0,0 +1,32 @@
+/*
+ * file: servo_hal_host.h
+ * author: J. van Hooydonk
+ * comments: servo motor driver, virtual-time register shim for a host build
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Port of a group of servos (16/10/2026)
+ *  v1.2 Read of timer 3 (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef SERVO_HAL_HOST_H
+#define	SERVO_HAL_HOST_H
+
+#include "config.h"
+
+// HAL of the servo driver (refer to servo_hal.h)
+#define SERVO_HAL_WRITE_PORT(group, value) \
+    hostServoWritePort((group), (uint8_t)(value))
+#define SERVO_HAL_WRITE_TMR3(value) hostServoWriteTmr3((uint16_t)(value))
+#define SERVO_HAL_READ_TMR3() hostServoReadTmr3()
+#define SERVO_HAL_WRITE_CCPR(value) hostServoWriteCcpr((uint16_t)(value))
+
+// shim routines (called by the servo driver through the HAL)
+void hostServoWritePort(uint8_t, uint8_t);
+void hostServoWriteTmr3(uint16_t);
+uint16_t hostServoReadTmr3(void);
+void hostServoWriteCcpr(uint16_t);
+
+#endif	/* SERVO_HAL_HOST_H */
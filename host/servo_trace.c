@@ -0,0 +1,347 @@
+/*
+ * file: servo_trace.c
+ * author: J. van Hooydonk
+ * comments: servo motor driver, host trace of the servo pulses
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Groups of servos with overlapped pulses (16/10/2026)
+ *  v1.2 Start positions given by the servo callback (16/10/2026)
+ *  v1.3 Idle servos and idle slots (SERVO_HOLD) (16/10/2026)
+ *  v1.4 Latency of the comparator interrupt (16/10/2026)
+ *  v1.5 Frame precomputed in the main loop (16/10/2026)
+ *  v1.6 Merged pulses end with the longest pulse (16/10/2026)
+ *  v1.7 Every pulse shorter than the position is an error (16/10/2026)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "servo.h"
+
+// definitions
+// the virtual time runs in ticks of timer 3 (Fosc / 4 / 8 = 2MHz = 0.5us)
+// the latency of the (high priority) interrupts is fixed (entry of the ISR
+// with the context save, 5us = 80 instruction cycles at 64MHz), the latency
+// of the timer 3 interrupt gets an extra random delay (e.g. the main loop
+// that holds off the interrupt in servoSetPosition)
+#define TRACE_LATENCY 10U
+#define TRACE_JITTER 4U
+// a pulse end that is ended at once by the ISR (the compare value was
+// already passed, refer to servoIsrCcp1) is not more than this late
+#define TRACE_LATE_MAX (2U * TRACE_LATENCY)
+// every write of a servo register takes one tick
+#define TRACE_WRITE 1U
+#define TRACE_FRAMES 5000U
+// the pulse starts one write after the timer reload, the pulse ends after
+// the latency of the comparator interrupt, so every pulse is longer by a
+// fixed offset
+#define TRACE_OFFSET (TRACE_LATENCY - TRACE_WRITE)
+// the servos move in turns (a quarter of the servos at once), one period in
+// five nobody moves (all servos idle)
+#define TRACE_PERIOD 250U
+// length of a frame (8 slots), every slot may be longer by the latency
+#define TRACE_FRAME (8UL * SERVO_SLOT_TICKS)
+#define TRACE_FRAME_MAX (TRACE_FRAME + 9UL * (TRACE_LATENCY + TRACE_JITTER))
+
+// declarations routines and variables
+static void traceCallback(uint8_t);
+static void traceRun(uint32_t);
+
+// the register file (refer to config.h)
+hostSfr_t hostSfr;
+
+static uint32_t traceTime;          // virtual time (in ticks of 0.5us)
+static uint32_t traceReload;        // time of the last timer 3 write
+static uint16_t traceTmr3;          // value of the last timer 3 write
+static uint16_t traceCcpr;          // compare value (CCP1)
+static bool traceMatched;           // compare match of the compare value
+static uint8_t tracePort[8];        // port of every group
+static uint32_t traceRise[8];       // time of the last rising edge (group)
+static uint16_t traceExpected[SERVO_COUNT]; // positions of the actual frame
+static uint16_t traceSnapshot[SERVO_COUNT]; // positions of the next frame
+static uint8_t traceEnabled[SERVO_GROUPS];  // enabled servos (actual frame)
+static uint8_t traceEnabledNext[SERVO_GROUPS]; // idem of the next frame
+static uint8_t traceActive;         // actual frame (servoFrames)
+static int traceGroup = -1;         // last group with pulses in the frame
+static uint32_t traceFrameStart;    // start of the actual frame
+static uint32_t traceFrameMin = UINT32_MAX; // min. and max. frame length
+static uint32_t traceFrameMax;
+static uint32_t traceInterrupts;    // interrupts of the actual frame
+static uint32_t traceInterruptsMin = UINT32_MAX; // per frame
+static uint32_t traceInterruptsMax;
+static uint32_t traceInterruptsTotal;
+static uint32_t traceRising;        // started pulses
+static uint32_t traceFrame;         // frame number (servo callback)
+static uint32_t tracePulses;
+static uint32_t traceMerged;        // pulses ended with a longer pulse
+static uint32_t traceMergedMax;     // max. error of these pulses (ticks)
+static uint32_t traceAtOnce;        // pulses ended after a passed compare
+static uint32_t traceShort;         // pulses shorter than the position
+static uint32_t traceErrors;
+static uint64_t traceSeed = 0x2545f4914f6cdd1dULL;
+
+/**
+ * main (start of program)
+ * usage: servo_trace [frames]
+ *        every servo sweeps with another speed, the width of every pulse
+ *        is compared with the position of the servo, the pulse ends that
+ *        are merged (SERVO_END_GAP) may be longer (less than the gap),
+ *        a pulse may never be shorter than the position (+ the latency)
+ *        only the enabled servos get a pulse (the others are idle, refer to
+ *        SERVO_HOLD) and every frame is 20ms (+ the interrupt latency)
+ * @return 0: all pulses are exact, 1: otherwise
+ */
+int main(int argc, char* argv[])
+{
+    uint32_t frames = (argc > 1) ? (uint32_t)atol(argv[1]) : TRACE_FRAMES;
+
+    servoInit(&traceCallback);
+    // the start positions (servoInit) are not a frame
+    traceFrame = 0;
+    memcpy(traceExpected, servoPortD, sizeof(traceExpected));
+    memcpy(traceEnabled, servoEnabled, sizeof(traceEnabled));
+    traceActive = servoActive;
+    traceRun(frames);
+
+    // every started pulse is ended (except the pulses of the last slot)
+    if (tracePulses + 8 < traceRising)
+    {
+        traceErrors++;
+    }
+    printf("servos             : %u (%u groups)\n", SERVO_COUNT, SERVO_GROUPS);
+    printf("frames             : %u (%.1f - %.1f ms)\n", traceFrame,
+            traceFrameMin / 2000.0, traceFrameMax / 2000.0);
+    printf("pulses             : %u\n", tracePulses);
+    printf("merged pulse ends  : %u (max. %.1f us longer)\n", traceMerged,
+            traceMergedMax / 2.0);
+    printf("ended at once      : %u\n", traceAtOnce);
+    printf("shorter pulses     : %u\n", traceShort);
+    printf("interrupts / frame : %u - %u (mean %.1f)\n", traceInterruptsMin,
+            traceInterruptsMax, (double)traceInterruptsTotal / traceFrame);
+    printf("errors             : %u\n", traceErrors);
+    return ((traceErrors == 0) && (tracePulses != 0)) ? 0 : 1;
+}
+
+/**
+ * run the virtual timer 3 and comparator (CCP1) for a number of frames
+ * the main loop (servoTask) runs after every interrupt
+ * @param frames: number of frames (20ms)
+ */
+static void traceRun(uint32_t frames)
+{
+    while (traceFrame < frames)
+    {
+        // search the next event: compare match or timer 3 overflow
+        uint32_t overflow = traceReload + (0x10000UL - traceTmr3);
+        uint32_t match = traceReload + (uint16_t)(traceCcpr - traceTmr3);
+        bool tmr3;
+        bool ccp = !traceMatched && (traceCcpr > traceTmr3) &&
+                (match >= traceTime) && (match < overflow);
+
+        if (ccp)
+        {
+            traceTime = match + TRACE_LATENCY;
+            traceMatched = true;
+            PIR6bits.CCP1IF = true;
+            tmr3 = false;
+        }
+        else
+        {
+            traceSeed ^= traceSeed >> 12;
+            traceSeed ^= traceSeed << 25;
+            traceSeed ^= traceSeed >> 27;
+            traceTime = overflow + TRACE_LATENCY +
+                    (uint32_t)((traceSeed * 0x2545f4914f6cdd1dULL) >>
+                    32) % (TRACE_JITTER + 1);
+            // the timer continues from 0x0000
+            traceReload = overflow;
+            traceTmr3 = 0x0000;
+            traceMatched = false;
+            PIR4bits.TMR3IF = true;
+            tmr3 = true;
+        }
+        servoIsr();
+        traceInterrupts++;
+        if (tmr3 && servoFrameFlag)
+        {
+            // start of a frame (first slot), the frame before must be 20ms
+            uint32_t length = traceReload - traceFrameStart;
+            if (traceFrameStart != 0)
+            {
+                if ((length < TRACE_FRAME) || (length > TRACE_FRAME_MAX))
+                {
+                    traceErrors++;
+                }
+                if (length < traceFrameMin) { traceFrameMin = length; }
+                if (length > traceFrameMax) { traceFrameMax = length; }
+                if (traceInterrupts < traceInterruptsMin)
+                {
+                    traceInterruptsMin = traceInterrupts;
+                }
+                if (traceInterrupts > traceInterruptsMax)
+                {
+                    traceInterruptsMax = traceInterrupts;
+                }
+                traceInterruptsTotal += traceInterrupts;
+            }
+            traceFrameStart = traceReload;
+            traceInterrupts = 0;
+            traceGroup = -1;
+        }
+        if (tmr3 && (servoSlot->group != SERVO_IDLE))
+        {
+            // the groups of a frame are in order
+            if ((int)servoSlot->group <= traceGroup)
+            {
+                traceErrors++;
+            }
+            traceGroup = servoSlot->group;
+        }
+        bool ready = servoFrameReady;
+        servoTask();
+        if (!ready && servoFrameReady)
+        {
+            // the next frame is precomputed with the actual positions and
+            // enabled servos
+            memcpy(traceSnapshot, servoPortD, sizeof(traceSnapshot));
+            memcpy(traceEnabledNext, servoEnabled, sizeof(traceEnabledNext));
+        }
+    }
+}
+
+/**
+ * this is the callback function for the servo update (every servo sweeps
+ * between 500us and 2500us with another step, the servos move in turns)
+ * @param index: the index of the servo
+ */
+static void traceCallback(uint8_t index)
+{
+    uint16_t step = (uint16_t)(7U + 13U * index);
+    uint16_t position = (uint16_t)(500U + ((traceFrame * step) % 2000U));
+
+    if ((traceFrame / TRACE_PERIOD) % 5U == index % 4U)
+    {
+        servoSetPosition(index, position);
+    }
+    if (index == SERVO_COUNT - 1)
+    {
+        traceFrame++;
+    }
+}
+
+// <editor-fold defaultstate="collapsed" desc="HAL routines">
+
+/**
+ * write the port of a group of servos, check the pulses at the falling edge
+ * @param group: the group of servos
+ * @param value: the port pattern
+ */
+void hostServoWritePort(uint8_t group, uint8_t value)
+{
+    uint8_t rising = value & (uint8_t)~tracePort[group];
+    uint8_t falling = tracePort[group] & (uint8_t)~value;
+
+    if (rising != 0)
+    {
+        // all pulses of the enabled servos of the group start at once
+        if ((group >= SERVO_GROUPS) || (rising != traceEnabled[group]) ||
+                (falling != 0))
+        {
+            traceErrors++;
+        }
+        traceRise[group] = traceTime;
+        traceRising += (uint32_t)__builtin_popcount(rising);
+    }
+    for (uint8_t i = 0; i < 8; i++)
+    {
+        if ((falling & (1 << i)) != 0)
+        {
+            // the pulse width must be the position (exact), or a bit
+            // longer if the pulse end is merged with a longer pulse, or
+            // a bit later than the position if the pulse is ended at once
+            // (a pulse that is not ended lasts till the next frame), a
+            // pulse that is ended with a compare value (CCP1) before its own
+            // pulse end is shorter than the position and is an error (even
+            // if the interrupt latency hides it)
+            uint32_t position = 2U * traceExpected[(group << 3) + i];
+            uint32_t width = traceTime - traceRise[group];
+            uint32_t expected = position + TRACE_OFFSET;
+            uint16_t end = (uint16_t)~(TIMER3_2500us - position);
+            if (((int16_t)(end - traceCcpr) > 0) || (width < position))
+            {
+                traceShort++;
+                traceErrors++;
+            }
+            else if (width == expected)
+            {
+            }
+            else if ((width > expected) && (width - expected < SERVO_END_GAP))
+            {
+                traceMerged++;
+                if (width - expected > traceMergedMax)
+                {
+                    traceMergedMax = width - expected;
+                }
+            }
+            else if (width <= position + TRACE_LATE_MAX)
+            {
+                traceAtOnce++;
+            }
+            else
+            {
+                traceErrors++;
+            }
+            tracePulses++;
+        }
+    }
+    tracePort[group] = value;
+    traceTime += TRACE_WRITE;
+}
+
+/**
+ * write timer 3
+ * @param value: the timer value
+ */
+void hostServoWriteTmr3(uint16_t value)
+{
+    // start of a slot, the precomputed frame is started at the start of a
+    // frame (if it is ready)
+    if (servoActive != traceActive)
+    {
+        memcpy(traceExpected, traceSnapshot, sizeof(traceExpected));
+        memcpy(traceEnabled, traceEnabledNext, sizeof(traceEnabled));
+        traceActive = servoActive;
+    }
+    traceReload = traceTime;
+    traceTmr3 = value;
+    traceMatched = false;
+    traceTime += TRACE_WRITE;
+}
+
+/**
+ * read timer 3
+ * @return the timer value
+ */
+uint16_t hostServoReadTmr3(void)
+{
+    uint16_t value = (uint16_t)(traceTmr3 + (traceTime - traceReload));
+
+    traceTime += TRACE_WRITE;
+    return value;
+}
+
+/**
+ * write the compare value of the comparator (CCP1)
+ * @param value: the compare value
+ */
+void hostServoWriteCcpr(uint16_t value)
+{
+    // a new compare value gives a new match (if the timer has not yet
+    // passed it)
+    traceCcpr = value;
+    traceMatched = false;
+    traceTime += TRACE_WRITE;
+}
+
+// </editor-fold>
@@ -7,6 +7,22 @@
  *  v0.1 Creation (14/01/2024)
  *  v1.0 Merge PIC18F2525/2620/4525/4620 and PIC18F24/25/26/27/45/46/47Q10 microcontrollers (20/07/2024)
  *  v1.1 Remove PIC18F2525/2620/4525/4620 (obsolete processor)
+ *  v1.2 Hardware abstraction layer (ln_hal.h) and host build (16/10/2026)
+ *  v1.3 LN TX and RX queues with complete LN messages (frames) (16/10/2026)
+ *  v1.4 Deferred RX dispatch (lnPoll) (16/10/2026)
+ *  v1.5 Incremental RX length and checksum (16/10/2026)
+ *  v1.6 RX filter (opcode and address) (16/10/2026)
+ *  v1.7 Driver statistics (16/10/2026)
+ *  v1.8 LN TX priority classes (16/10/2026)
+ *  v1.9 Adaptive collision backoff (16/10/2026)
+ *  v1.10 Seed of the random generator (unique ID) (16/10/2026)
+ *  v1.11 Event-driven start of the transmission (16/10/2026)
+ *  v1.12 Tickless idle mode (16/10/2026)
+ *  v1.13 Transmit a LN message from a buffer (lnTxSend) (16/10/2026)
+ *  v1.14 TX backpressure (status and space available callback) (16/10/2026)
+ *  v1.15 Transmit a LN message with checksum (lnTxPrioritySendRaw) (16/10/2026)
+ *  v1.16 No restart of the LN message being transmitted (16/10/2026)
+ *  v1.17 Interrupt state kept by lnSetRxFilterAddress (16/10/2026)
 */
 
 #include "ln.h"
@@ -21,13 +37,45 @@ void lnInit(lnRxMsgCallback_t fptr)
 {
     // init LN RX message callback function (function pointer)
     lnRxMsgCallback = fptr;
+    lnTxSpaceCallback = NULL;
     
     // declaration and initialisation of the RX and TX queue
     // essentially the queue is just a pointer to the instance of the struct
-    initQueue(&lnTxQueue);
-    initQueue(&lnTxTempQueue);
-    initQueue(&lnRxQueue);
-    initQueue(&lnRxTempQueue);
+    for (uint8_t i = 0; i < LN_TX_PRIORITIES; i++)
+    {
+        initFrameQueue(&lnTxQueue[i]);
+        lnTxWaitLength[i] = 0;
+        lnTxClassStats[i].sent = 0;
+        lnTxClassStats[i].waitTotal = 0;
+        lnTxClassStats[i].waitMax = 0;
+    }
+    lnTxPriority = 0;
+    lnTxSequence = 0;
+    lnBackoffBits = LN_BACKOFF_MIN_BITS;
+    // seed the random generator with the unique ID of the device, so
+    // identical devices that are powered on together don't get the same
+    // CMP delays (and don't keep colliding)
+    lastRandomValue = 0;
+    for (uint8_t i = 0; i < LN_HAL_MUI_SIZE; i++)
+    {
+        uint8_t value;
+        LN_HAL_READ_MUI(i, value);
+        lnSeedRandom(value);
+    }
+    initFrameQueue(&lnRxQueue);
+    lnRxLength = 0;
+    LNCON.TX_ACTIVE = false;
+    LNCON.TX_ECHO = false;
+    LNCON.TX_RETRY = false;
+    // accept all LN messages (till the RX filter is set)
+    lnInitRxFilter(true);
+    // clear the statistics
+    lnStats.rxFrames = 0;
+    lnStats.txFrames = 0;
+    lnStats.checksumErrors = 0;
+    lnStats.framingErrors = 0;
+    lnStats.collisions = 0;
+    lnStats.retransmits = 0;
     
     // init of the other elements (clock, comparator, EUSART, timer, ISR, leds)
     lnInitCmp1();
@@ -87,7 +135,7 @@ void lnInitEusart1(void)
     TX1STAbits.BRGH = false;    // low speed    
     RC1STAbits.CREN = false;    // first clear bit CREN to clear the OERR bit
     RC1STAbits.CREN = true;     // enable receiver
-    _ = RC1REG;                 // read the receive register to clear his
+    _ = LN_HAL_READ_RX();       // read the receive register to clear his
                                 // content and to clear the FERR bit
 
     setBrg1();                  // set and enable the BRG
@@ -155,26 +203,27 @@ void lnInitLeds(void)
  */
 void __interrupt(low_priority) lnIsr(void)
 {
-    if (PIR4bits.TMR1IF)
+    if (LN_HAL_IS_TMR1_IF())
     {
         // timer 1 interrupt
         // clear the interrupt flag and handle the request
-        PIR4bits.TMR1IF = false;
+        LN_HAL_CLEAR_TMR1_IF();
         lnIsrTmr1();
     }
-    else if (PIR3bits.RC1IF)
+    else if (LN_HAL_IS_RC_IF())
     {
         // EUSART RC interupt
-        if (RC1STAbits.FERR)
+        if (LN_HAL_IS_FERR())
         {
             // EUSART framing error (linebreak detected)
             // read RCREG to clear the interrupt flag and FERR bit
-            _ = RC1REG;
-            // retreive (recover) the last transmitted LN message
-            recoverLnMessage(&lnTxTempQueue);
-            // this framing error detection takes about 600s
-            // (10bits x 60s) and a linebreak duration is specified at
-            // 900s, so add 300s after this detection time to complete
+            _ = LN_HAL_READ_RX();
+            lnStats.framingErrors++;
+            // the last transmitted LN message is recovered in
+            // startLinebreak
+            // this framing error detection takes about 600µs
+            // (10bits x 60µs) and a linebreak duration is specified at
+            // 900µs, so add 300µs after this detection time to complete
             // a full linebreak
             startLinebreak(LINEBREAK_SHORT);
         }
@@ -199,20 +248,29 @@ void lnIsrTmr1(void)
     switch (LNCON.TMR1_MODE)
     {
         case 0:
-            // LN driver is in idle mode
+        case 1:
+            // LN driver is in idle mode (the line is idle since the end of
+            // the last CMP delay) or the CMP delay is passed, so a LN
+            // message is started at once (without waiting for an idle tick)
             if (isLnFree())
             {
                 // LN is free
-                if (!isQueueEmpty(&lnTxTempQueue))
+                if (LNCON.TX_ACTIVE)
                 {
-                    // if LN TX temporary queue is not empty restart
+                    // if the LN TX message is not completed restart
                     // the tramsmission (there is still something to be sent)
                     // this may occur when the last TX message was transmitted
                     // with errors (eg. after linebreak, conflict RX-TX, ...)
-                    // start sync BRG before transmitting the first data byte
-                    startSyncBrg1();
+                    // a LN message of a higher class that is queued in the
+                    // meantime goes first
+                    if (LNCON.TX_RETRY)
+                    {
+                        LNCON.TX_RETRY = false;
+                        lnStats.retransmits++;
+                    }
+                    startLnTxMessage();
                 }
-                else if (!isQueueEmpty(&lnTxQueue))
+                else if (isLnTxPending())
                 {
                     // if LN TX queue has a LN message 
                     startLnTxMessage();
@@ -220,8 +278,13 @@ void lnIsrTmr1(void)
                 else
                 {
                     // LN is free but nothing has to be transmitted
-                    // restart timer 1 with idle delay
-                    startIdleDelay();
+                    #if LN_TICKLESS
+                        // stop timer 1 till the next LN event
+                        stopTimer1();
+                    #else
+                        // restart timer 1 with idle delay
+                        startIdleDelay();
+                    #endif
                 }
             }
             else
@@ -230,23 +293,10 @@ void lnIsrTmr1(void)
                 startCmpDelay();
             }
             break;
-        case 1:
-            // after the CMP delay
-            if (isLnFree())
-            {
-                // if LN line is free start timer 1 with idle delay
-                startIdleDelay();
-            }
-            else
-            {
-                // if LN line is not free restart timer 1 with CMP delay
-                startCmpDelay();
-            }
-            break;
         case 2:
             // after the linebreak (delay) start CMP delay
-            RC1STAbits.SPEN = true; // (re-)enable the receiver
-            PORTCbits.RC6 = false;      // and restore output pin
+            LN_HAL_SET_RX_ENABLE(true); // (re-)enable the receiver
+            LN_HAL_SET_TX_PIN(false);   // and restore output pin
             startCmpDelay();            // start the timer 1 with CMP delay
             break;
         case 3:
@@ -269,34 +319,59 @@ void lnIsrTmr1(void)
 void lnIsrRc(void)
 {
     // get the received value
-    uint8_t lnRxData = RC1REG;
+    uint8_t lnRxData = LN_HAL_READ_RX();
 
-    if (!isQueueEmpty(&lnTxTempQueue))
+    if (LNCON.TX_ECHO)
     {
-        // device is in TX mode
+        // device is in TX mode (this is the echo of the transmitted byte)
+        // a byte of an other device that is received while a LN TX
+        // message is waiting to be retransmitted is handled as RX data
+        LNCON.TX_ECHO = false;
         // check if received byte = transmitted byte
-        if (lnRxData == lnTxTempQueue.values[lnTxTempQueue.head])
+        if (lnRxData == peekFrame(&lnTxQueue[lnTxPriority], lnTxIndex))
         {
-            // if last value is correct transmitted then dequeue
-            deQueue(&lnTxTempQueue);
-            if (!isQueueEmpty(&lnTxTempQueue))
+            // if last value is correct transmitted then go to the next one
+            lnTxIndex++;
+            if (lnTxIndex < getFrameLength(&lnTxQueue[lnTxPriority]))
             {
-                // send next data of LN message untill queue is empty
+                // send next data of LN message untill the end
                 txHandler();
             }
             else
             {
+                // the LN message is transmitted, remove it from the queue
+                lnTxClassStats_t* stats = &lnTxClassStats[lnTxPriority];
+                uint8_t wait = lnTxSequence - lnTxStamp[lnTxPriority]
+                        [lnTxQueue[lnTxPriority].head & FRAME_QUEUE_MASK];
+                stats->sent++;
+                stats->waitTotal += wait;
+                if (wait > stats->waitMax)
+                {
+                    stats->waitMax = wait;
+                }
+                deQueueFrame(&lnTxQueue[lnTxPriority]);
+                LNCON.TX_ACTIVE = false;
+                lnStats.txFrames++;
+                lnTxSequence++;
+                #if LN_ADAPTIVE_BACKOFF
+                    // shrink the random window of the CMP delay
+                    if (lnBackoffBits > LN_BACKOFF_MIN_BITS)
+                    {
+                        lnBackoffBits--;
+                    }
+                #endif
                 // restart CMP delay
                 startCmpDelay();
                 #if LN_RX_TX_LED
                     // led 'data on LN TX' on (active high)
-                    LATEbits.LATE1 = true;
+                    LN_HAL_SET_LED_TX(true);
                 #endif
             }
         }
         else
         {
             // if LN RX data is not equal to LN TX data send linebreak
+            lnStats.collisions++;
             startLinebreak(LINEBREAK_LONG);
         }
     }
@@ -317,6 +392,9 @@ void lnIsrRc(void)
 
 /**
  * EUSART RX handler
+ * the received bytes are written directly in the LN RX queue, the length
+ * and the checksum are kept up to date with every byte, so the end of a
+ * LN message costs the same time for every length
  * @param lnRxData: the received databyte
  */
 void rxHandler(uint8_t lnRxData)
@@ -324,58 +402,272 @@ void rxHandler(uint8_t lnRxData)
     // start testing if msb = 1 (this is the startbyte of the LN message)
     if ((lnRxData & 0x80) == 0x80)
     {
-        clearQueue(&lnRxTempQueue);
-        enQueue(&lnRxTempQueue, lnRxData);
-    }
-    else
-    {
-        enQueue(&lnRxTempQueue, lnRxData);
-
-        // determine length of LN message
-        uint8_t lnMessageLength;
-        lnMessageLength = (lnRxTempQueue.values[lnRxTempQueue.head] & 0x60);
-        lnMessageLength = (lnMessageLength >> 4) + 2;
-        if (lnMessageLength > 6)
+        // drop the previous LN message if it is not complete
+        if (lnRxLength != 0)
         {
-            lnMessageLength = lnRxTempQueue.values[lnRxTempQueue.head + 1];
+            abortFrame(&lnRxQueue);
         }
-
-        // has LN message reached the end the test checksum
-        if (lnMessageLength == lnRxTempQueue.numEntries)
+        // determine length of LN message (2, 4 or 6 bytes, or 8 = the
+        // length is the next byte)
+        lnRxLength = ((lnRxData & 0x60) >> 4) + 2;
+        lnRxCount = 0;
+        lnRxChecksum = 0;
+        // drop a LN message with an opcode that is not accepted
+        // (before anything is written in the LN RX queue)
+        if (!isRxFilterAccepted(lnRxData))
+        {
+            lnRxLength = 0;
+            return;
+        }
+        // reserve room in the LN RX queue (otherwise the LN message is
+        // dropped), for a variable length the room is checked again with
+        // the length byte
+        if (!beginFrame(&lnRxQueue, (lnRxLength > 6) ? 2 : lnRxLength))
         {
-            if (isChecksumCorrect(&lnRxTempQueue))
+            lnRxLength = 0;
+            return;
+        }
+    }
+    else if (lnRxLength == 0)
+    {
+        // no start byte received (or the LN message is dropped)
+        return;
+    }
+    else if (lnRxCount == 1)
+    {
+        if (lnRxLength > 6)
+        {
+            // length byte of a variable length LN message
+            if ((lnRxData < 3) || !isFrameQueueRoom(&lnRxQueue, lnRxData - 1))
             {
-                // if checksum is correct then copy LN RX temp queue to
-                // LN RX queue
-                while (!isQueueEmpty(&lnRxTempQueue))
+                if (lnRxData >= 3)
                 {
-                    enQueue(&lnRxQueue, lnRxTempQueue.values[lnRxTempQueue.head]);
-                    deQueue(&lnRxTempQueue);
+                    // no room for the complete LN message
+                    lnRxQueue.data.overflows++;
                 }
-                #if LN_RX_TX_LED
-                    // led 'data on LN RX' on (active high)
-                    LATEbits.LATE0 = true;
-                #endif
+                abortFrame(&lnRxQueue);
+                lnRxLength = 0;
+                return;
+            }
+            lnRxLength = lnRxData;
+        }
+        lnRxSw1 = lnRxData;
+    }
+    else if ((lnRxCount == 2) && LNCON.RX_ADDRESSED)
+    {
+        // drop a LN message with an address that does not match
+        uint16_t address = (lnRxSw1 & 0x7f) | ((uint16_t)(lnRxData & 0x0f) << 7);
+        if (((address ^ lnRxFilter.address) & lnRxFilter.mask) != 0)
+        {
+            abortFrame(&lnRxQueue);
+            lnRxLength = 0;
+            return;
+        }
+    }
+
+    putFrame(&lnRxQueue, lnRxData);
+    lnRxChecksum ^= lnRxData;
+    lnRxCount++;
+
+    // has LN message reached the end then test checksum
+    if (lnRxCount == lnRxLength)
+    {
+        lnRxLength = 0;
+        if (lnRxChecksum == 0xff)
+        {
+            // make the LN message visible in the LN RX queue
+            commitFrame(&lnRxQueue);
+            lnStats.rxFrames++;
+            #if LN_RX_TX_LED
+                // led 'data on LN RX' on (active high)
+                LN_HAL_SET_LED_RX(true);
+            #endif
+            #if !LN_RX_DEFERRED
                 // handle LN RX message (in the callback function)
                 (*lnRxMsgCallback)(&lnRxQueue);
+            #endif
+        }
+        else
+        {
+            abortFrame(&lnRxQueue);
+            lnStats.checksumErrors++;
+        }
+    }
+}
+
+/**
+ * LN poll routine (call this routine in the main loop)
+ * the received LN messages are handed over to the callback function outside
+ * the ISR, so the ISR time stays short under a heavy RX load
+ * the LN RX queue is a single producer (ISR) / single consumer (main loop)
+ * queue, so a filled LN RX queue is the 'message ready' flag
+ * if a LN message was rejected (LN_TX_FULL) and the LN TX queue of the
+ * class has room for it now, the space available callback is called
+ */
+void lnPoll(void)
+{
+    #if LN_RX_DEFERRED
+        if (!isFrameQueueEmpty(&lnRxQueue))
+        {
+            // handle LN RX messages (in the callback function)
+            (*lnRxMsgCallback)(&lnRxQueue);
+        }
+    #endif
+    for (uint8_t i = 0; i < LN_TX_PRIORITIES; i++)
+    {
+        uint8_t length = lnTxWaitLength[i];
+        if ((length != 0) && isFrameQueueRoom(&lnTxQueue[i], length))
+        {
+            // the wait is cleared before the callback, so a producer that
+            // is rejected again (in the callback or in an ISR) waits again
+            lnTxWaitLength[i] = 0;
+            if (lnTxSpaceCallback != NULL)
+            {
+                (*lnTxSpaceCallback)(i);
             }
         }
-    }     
+    }
+}
+
+/**
+ * set the (optional) callback function that is called by lnPoll when a
+ * LN TX queue has room again after a rejected LN message (LN_TX_FULL)
+ * @param fptr: the function pointer to the callback function (or NULL)
+ */
+void lnSetTxSpaceCallback(lnTxSpaceCallback_t fptr)
+{
+    lnTxSpaceCallback = fptr;
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="RX filter">
+
+/**
+ * initialisation of the RX filter
+ * @param accept: true = accept all opcodes, false = accept no opcode
+ */
+void lnInitRxFilter(bool accept)
+{
+    for (uint8_t i = 0; i < 16; i++)
+    {
+        lnRxFilter.opcodes[i] = accept ? 0xff : 0x00;
+        lnRxFilter.addressed[i] = 0x00;
+    }
+    lnRxFilter.address = 0;
+    lnRxFilter.mask = 0;
 }
 
 /**
- * calculate the checksum
- * @param lnQueue: name of the queue (pass the address of the queue)
- * @return true: if checksum is correct 
+ * accept an opcode in the RX filter
+ * @param opcode: the opcode of the LN message
+ * @param addressed: true = the address (SW1/SW2 fields) must match too
  */
-bool isChecksumCorrect(lnQueue_t* lnQueue)
+void lnSetRxFilter(uint8_t opcode, bool addressed)
 {
-    uint8_t checksum = 0;    
-    for (uint8_t i = 0; i < lnQueue->numEntries; i++)
+    uint8_t index = (opcode >> 3) & 0x0f;
+    uint8_t bit = (uint8_t)(1 << (opcode & 0x07));
+
+    lnRxFilter.opcodes[index] |= bit;
+    if (addressed)
     {
-        checksum ^= lnQueue->values[(lnQueue->head + i) % lnQueue->size];
-    }    
-    return (checksum == 0xff);
+        lnRxFilter.addressed[index] |= bit;
+    }
+    else
+    {
+        lnRxFilter.addressed[index] &= (uint8_t)~bit;
+    }
+}
+
+/**
+ * set the address of the RX filter (for the addressed opcodes)
+ * the address is used in the ISR, so the low priority interrupts are
+ * disabled while the (16 bit) values are written
+ * @param address: the address (11 bits)
+ * @param mask: the address bits to compare
+ */
+void lnSetRxFilterAddress(uint16_t address, uint16_t mask)
+{
+    // keep the interrupt state of the caller
+    bool giel = INTCONbits.GIEL;
+
+    INTCONbits.GIEL = false;
+    lnRxFilter.address = address;
+    lnRxFilter.mask = mask;
+    INTCONbits.GIEL = giel;
+}
+
+/**
+ * test the opcode of a LN message with the RX filter
+ * @param opcode: the opcode of the LN message
+ * @return true: if the opcode is accepted
+ */
+bool isRxFilterAccepted(uint8_t opcode)
+{
+    uint8_t index = (opcode >> 3) & 0x0f;
+    uint8_t bit = (uint8_t)(1 << (opcode & 0x07));
+
+    LNCON.RX_ADDRESSED = ((lnRxFilter.addressed[index] & bit) != 0);
+    return ((lnRxFilter.opcodes[index] & bit) != 0);
+}
+
+// </editor-fold>
+
+// <editor-fold defaultstate="collapsed" desc="statistics">
+
+/**
+ * get a page (8 bytes) of the statistics, the 16 bit values are little
+ * endian (low byte first)
+ * page 0: rxFrames, txFrames, checksumErrors, framingErrors
+ * page 1: collisions, retransmits,
+ *         overflows of the LN RX queue, high-water mark (bytes) of the
+ *         LN RX queue, high-water mark (LN messages) of the LN RX queue, 0
+ * page 2 + class: sent, waitTotal, waitMax of the LN TX priority class,
+ *         high-water mark (LN messages) of the LN TX queue of the class,
+ *         overflows of the LN TX queue, high-water mark (bytes)
+ * the other pages are 0
+ * @param page: the page number
+ * @param data: pointer to the 8 bytes of the page
+ */
+void getLnStats(uint8_t page, uint8_t* data)
+{
+    uint16_t values[4] = { 0, 0, 0, 0 };
+    bool giel = INTCONbits.GIEL;
+
+    // the counters are changed in the ISR, so take a snapshot with the low
+    // priority interrupts disabled
+    INTCONbits.GIEL = false;
+    if (page == 0)
+    {
+        values[0] = lnStats.rxFrames;
+        values[1] = lnStats.txFrames;
+        values[2] = lnStats.checksumErrors;
+        values[3] = lnStats.framingErrors;
+    }
+    else if (page == 1)
+    {
+        values[0] = lnStats.collisions;
+        values[1] = lnStats.retransmits;
+        values[2] = lnRxQueue.data.overflows |
+                ((uint16_t)lnRxQueue.data.peak << 8);
+        values[3] = lnRxQueue.peak;
+    }
+    else if (page < 2 + LN_TX_PRIORITIES)
+    {
+        lnTxClassStats_t* stats = &lnTxClassStats[page - 2];
+        lnFrameQueue_t* queue = &lnTxQueue[page - 2];
+        values[0] = stats->sent;
+        values[1] = stats->waitTotal;
+        values[2] = stats->waitMax | ((uint16_t)queue->peak << 8);
+        values[3] = queue->data.overflows | ((uint16_t)queue->data.peak << 8);
+    }
+    INTCONbits.GIEL = giel;
+
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        data[2 * i] = (uint8_t)values[i];
+        data[2 * i + 1] = (uint8_t)(values[i] >> 8);
+    }
 }
 
 // </editor-fold>
@@ -383,22 +675,183 @@ bool isChecksumCorrect(lnQueue_t* lnQueue)
 // <editor-fold defaultstate="collapsed" desc="TX routines">
 
 /**
- * start routine for transmitting a LN message
+ * start routine for transmitting a LN message (normal priority class)
  * @param the message to transmit
+ * @return LN_TX_OK, LN_TX_FULL or LN_TX_INVALID
  */
-void lnTxMessageHandler(lnQueue_t* lnTxMsg)
+lnTxStatus_t lnTxMessageHandler(lnQueue_t* lnTxMsg)
+{
+    return lnTxPriorityMessageHandler(lnTxMsg, LN_TX_PRIORITY_NORMAL);
+}
+
+/**
+ * start routine for transmitting a LN message in a priority class
+ * every class has one producer (e.g. the high priority ISR for the high
+ * class and the main loop for the normal class)
+ * the message queue is always emptied (also if the LN message is rejected)
+ * @param the message to transmit
+ * @param priority: the priority class (0 = highest)
+ * @return LN_TX_OK, LN_TX_FULL or LN_TX_INVALID
+ */
+lnTxStatus_t lnTxPriorityMessageHandler(lnQueue_t* lnTxMsg, uint8_t priority)
 {
     // copy the LN message into the LN TX queue
     // and add the calculated checksum
+    lnFrameQueue_t* queue = &lnTxQueue[priority];
+    uint8_t length = getQueueCount(lnTxMsg);
     uint8_t checksum = 0x00;
-    
+
+    // the LN message (+ checksum) is only put in the LN TX queue if there
+    // is room for the complete LN message
+    if ((length == 0) || (length >= QUEUE_SIZE))
+    {
+        clearQueue(lnTxMsg);
+        return LN_TX_INVALID;
+    }
+    if (!beginFrame(queue, length + 1))
+    {
+        clearQueue(lnTxMsg);
+        lnTxWaitLength[priority] = length + 1;
+        return LN_TX_FULL;
+    }
     while (!isQueueEmpty(lnTxMsg))
     {
-        checksum ^= lnTxMsg->values[lnTxMsg->head];
-        enQueue(&lnTxQueue, lnTxMsg->values[lnTxMsg->head]);
+        checksum ^= peekQueue(lnTxMsg, 0);
+        putFrame(queue, peekQueue(lnTxMsg, 0));
         deQueue(lnTxMsg);
     }
-    enQueue(&lnTxQueue, (checksum ^ 0xff));
+    putFrame(queue, (checksum ^ 0xff));
+    commitLnTxMessage(priority);
+    return LN_TX_OK;
+}
+
+/**
+ * transmit a LN message (normal priority class)
+ * @param msg: the LN message (without checksum)
+ * @param length: the length of the LN message (without checksum)
+ * @return LN_TX_OK, LN_TX_FULL or LN_TX_INVALID
+ */
+lnTxStatus_t lnTxSend(const uint8_t* msg, uint8_t length)
+{
+    return lnTxPrioritySend(msg, length, LN_TX_PRIORITY_NORMAL);
+}
+
+/**
+ * transmit a LN message in a priority class
+ * the room for the complete LN message (+ checksum) is reserved in the LN
+ * TX queue and the bytes are written once, the LN message is transmitted
+ * from the LN TX queue itself
+ * @param msg: the LN message (without checksum)
+ * @param length: the length of the LN message (without checksum)
+ * @param priority: the priority class (0 = highest)
+ * @return LN_TX_OK, LN_TX_FULL or LN_TX_INVALID
+ */
+lnTxStatus_t lnTxPrioritySend(const uint8_t* msg, uint8_t length, uint8_t priority)
+{
+    lnFrameQueue_t* queue = &lnTxQueue[priority];
+    uint8_t checksum = 0xff;
+
+    if ((length == 0) || (length >= QUEUE_SIZE))
+    {
+        return LN_TX_INVALID;
+    }
+    if (!beginFrame(queue, length + 1))
+    {
+        // the producer gets the space available callback (refer to lnPoll)
+        lnTxWaitLength[priority] = length + 1;
+        return LN_TX_FULL;
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+        checksum ^= msg[i];
+        putFrame(queue, msg[i]);
+    }
+    putFrame(queue, checksum);
+    commitLnTxMessage(priority);
+    return LN_TX_OK;
+}
+
+/**
+ * transmit a ready-made LN message (checksum included) in a priority class
+ * the bytes are copied as they are in the LN TX queue (no calculation)
+ * @param frame: the LN message (with checksum)
+ * @param length: the length of the LN message (with checksum)
+ * @param priority: the priority class (0 = highest)
+ * @return LN_TX_OK, LN_TX_FULL or LN_TX_INVALID
+ */
+lnTxStatus_t lnTxPrioritySendRaw(const uint8_t* frame, uint8_t length, uint8_t priority)
+{
+    lnFrameQueue_t* queue = &lnTxQueue[priority];
+
+    if ((length < 2) || (length > QUEUE_SIZE))
+    {
+        return LN_TX_INVALID;
+    }
+    if (!beginFrame(queue, length))
+    {
+        // the producer gets the space available callback (refer to lnPoll)
+        lnTxWaitLength[priority] = length;
+        return LN_TX_FULL;
+    }
+    for (uint8_t i = 0; i < length; i++)
+    {
+        putFrame(queue, frame[i]);
+    }
+    commitLnTxMessage(priority);
+    return LN_TX_OK;
+}
+
+/**
+ * make the new LN message in the LN TX queue of a class visible and start
+ * the transmission (if the LN driver is idle)
+ * @param priority: the priority class
+ */
+void commitLnTxMessage(uint8_t priority)
+{
+    lnFrameQueue_t* queue = &lnTxQueue[priority];
+
+    // stamp the LN message to measure the wait (before it is visible)
+    lnTxStamp[priority][queue->tail & FRAME_QUEUE_MASK] = lnTxSequence;
+    commitFrame(queue);
+    kickLnTx();
+}
+
+/**
+ * start the transmission at once if the LN driver is in idle mode (the CMP
+ * delay is already passed), in the other modes the LN message is started
+ * at the end of the running delay (refer to lnIsrTmr1)
+ * the mode stays 0 while a LN message is transmitted (after the BRG
+ * synchronisation), so there is no request during a transmission (this
+ * would restart the LN message in the middle of the frame)
+ */
+void kickLnTx(void)
+{
+    // the mode is changed in the ISR, so the low priority interrupts are
+    // disabled between the test and the timer 1 interrupt request
+    bool giel = INTCONbits.GIEL;
+
+    INTCONbits.GIEL = false;
+    if ((LNCON.TMR1_MODE == 0) && !LNCON.TX_ACTIVE && !LNCON.TX_ECHO)
+    {
+        LN_HAL_SET_TMR1_IF();
+    }
+    INTCONbits.GIEL = giel;
+}
+
+/**
+ * check if a LN message is waiting to be transmitted (in any class)
+ * @return true: if a LN TX queue is not empty
+ */
+bool isLnTxPending(void)
+{
+    for (uint8_t i = 0; i < LN_TX_PRIORITIES; i++)
+    {
+        if (!isFrameQueueEmpty(&lnTxQueue[i]))
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 /**
@@ -407,14 +860,18 @@ void lnTxMessageHandler(lnQueue_t* lnTxMsg)
 void startLnTxMessage(void)
 {
     // this routine is driven by (timer) interrupt, so don't call it directly
-    // first, copy next LN message from LN TX queue into LN TX temporary queue
-    do
+    // the first LN message of the highest non-empty LN TX queue is
+    // transmitted from the queue itself, it stays in the queue till the
+    // last byte is transmitted
+    for (lnTxPriority = 0; lnTxPriority < LN_TX_PRIORITIES - 1; lnTxPriority++)
     {
-        enQueue(&lnTxTempQueue, lnTxQueue.values[lnTxQueue.head]);
-        deQueue(&lnTxQueue);
+        if (!isFrameQueueEmpty(&lnTxQueue[lnTxPriority]))
+        {
+            break;
+        }
     }
-    while (!isQueueEmpty(&lnTxQueue) &&
-            ((lnTxQueue.values[lnTxQueue.head] & 0x80) != 0x80));
+    LNCON.TX_ACTIVE = true;
+    lnTxIndex = 0;
     // sync BRG before transmitting the first data byte
     startSyncBrg1();            
 }
@@ -426,10 +883,11 @@ void txHandler(void)
 {
     if (isLnFree())
     {
-        // the last transmited value (TX1REG) must be stored (in lnTxData)
-        // this is necessary to check if the data is transmitted correctly
-        // (see routine rxHandler)
-        TX1REG = lnTxTempQueue.values[lnTxTempQueue.head];
+        // the transmitted value (TX1REG) stays in the LN TX queue (at
+        // lnTxIndex), this is necessary to check if the data is transmitted
+        // correctly (see routine lnIsrRc)
+        LN_HAL_WRITE_TX(peekFrame(&lnTxQueue[lnTxPriority], lnTxIndex));
+        LNCON.TX_ECHO = true;
     }
     else
     {
@@ -451,25 +909,43 @@ bool isLnFree(void)
     // check if:
     //  RC7 = 1 (PORT C, bit 7 = high)
     //  RCIDL = 1 (receiver is idle = no data reception in progress)
-    return (PORTCbits.RC7 && BAUD1CONbits.RCIDL);
+    return (LN_HAL_IS_LINE_IDLE());
 }
 // </editor-fold>
 
 // <editor-fold defaultstate="collapsed" desc="timer 1 routines">
 
 /**
- * start of the idle delay (1000s)
+ * start of the idle delay (1000µs)
  */
 void startIdleDelay(void)
 {
-    // delay = 1000s (timer 1 in idle mode)
-    WRITETIMER1(~TIMER1_IDLE);      // set delay in timer 1
+    // delay = 1000µs (timer 1 in idle mode)
+    LN_HAL_WRITE_TMR1(~TIMER1_IDLE);// set delay in timer 1
+    LN_HAL_SET_TMR1_ON(true);       // (re)start timer 1 (tickless mode)
     LNCON.TMR1_MODE = 0;            // 0: timer 1 in idle mode    
     // in idle mode, the leds on LN (RX + TX) can be turned off (active high)
-    LATAbits.LATA5 = false;
+    LN_HAL_SET_LED_LN(false);
+    #if LN_RX_TX_LED
+        LN_HAL_SET_LED_RX(false);
+        LN_HAL_SET_LED_TX(false);
+    #endif
+}
+
+/**
+ * stop timer 1 in idle mode (tickless mode), the LN driver stays in idle
+ * mode till a byte is received (lnIsrRc starts the CMP delay) or a LN
+ * message is queued (kickLnTx requests a timer 1 interrupt)
+ */
+void stopTimer1(void)
+{
+    LN_HAL_SET_TMR1_ON(false);      // stop timer 1
+    LNCON.TMR1_MODE = 0;            // 0: timer 1 in idle mode
+    // in idle mode, the leds on LN (RX + TX) can be turned off (active high)
+    LN_HAL_SET_LED_LN(false);
     #if LN_RX_TX_LED
-        LATEbits.LATE0 = false;
-        LATEbits.LATE1 = false;
+        LN_HAL_SET_LED_RX(false);
+        LN_HAL_SET_LED_TX(false);
     #endif
 }
 
@@ -478,15 +954,21 @@ void startIdleDelay(void)
  */
 void startCmpDelay(void)
 {
-    // delay CMP = 1200s + 360s + random (between 0s and 1023s)
+    // delay CMP = 1200µs + 360µs + random (between 0µs and 1023µs)
     uint16_t delay = getRandomValue(lastRandomValue);
     lastRandomValue = delay;        // store last value of random generator
-    delay &= 2047U;             // get random value between 0 and 1023
-    delay += 3120U;             // add C + M delay (= 1560s)
-    WRITETIMER1(~delay);            // set delay in timer 1
+    #if LN_ADAPTIVE_BACKOFF
+        // random value between 0 and 2^lnBackoffBits ticks
+        delay &= (uint16_t)((1U << lnBackoffBits) - 1U);
+    #else
+        delay &= 2047U;         // get random value between 0 and 1023
+    #endif
+    delay += 3120U;             // add C + M delay (= 1560µs)
+    LN_HAL_WRITE_TMR1(~delay);      // set delay in timer 1
+    LN_HAL_SET_TMR1_ON(true);       // (re)start timer 1 (tickless mode)
     LNCON.TMR1_MODE = 1;            // 1: timer 1 in CMP delay mode
     // led 'data on LN' on (active high)
-    LATAbits.LATA5 = true;
+    LN_HAL_SET_LED_LN(true);
 }
 
 /**
@@ -510,6 +992,21 @@ uint16_t getRandomValue(uint16_t lfsr)
     return lfsr;
 }
 
+/**
+ * mix a value in the state of the random generator (e.g. the address of
+ * the device), call this routine after lnInit
+ * @param value: the value to mix in
+ */
+void lnSeedRandom(uint16_t value)
+{
+    lastRandomValue = ((lastRandomValue << 5) | (lastRandomValue >> 11)) ^ value;
+    // the state 0 is never left by the LFSR
+    if (lastRandomValue == 0)
+    {
+        lastRandomValue = 0xace1u;
+    }
+}
+
 /**
  * start of the linebreak delay (with a well defined time)
  * @param the time of the linebreak
@@ -518,10 +1015,27 @@ uint16_t getRandomValue(uint16_t lfsr)
 void startLinebreak(uint16_t time)
 {
     // linebreak detect by framing error
-    RC1STAbits.SPEN = false;    // stop EUSART
-    PORTCbits.RC6 = true;
+    // recover the LN TX message: after the linebreak the complete LN
+    // message is transmitted again (from the first byte)
+    lnTxIndex = 0;
+    LNCON.TX_ECHO = false;
+    if (LNCON.TX_ACTIVE)
+    {
+        // the LN message is transmitted again after the linebreak
+        LNCON.TX_RETRY = true;
+    }
+    #if LN_ADAPTIVE_BACKOFF
+        // grow the random window of the CMP delay
+        if (lnBackoffBits < LN_BACKOFF_MAX_BITS)
+        {
+            lnBackoffBits++;
+        }
+    #endif
+    LN_HAL_SET_RX_ENABLE(false);// stop EUSART
+    LN_HAL_SET_TX_PIN(true);
     // a LN linebreak definition 
-    WRITETIMER1(~time);
+    LN_HAL_WRITE_TMR1(~time);
+    LN_HAL_SET_TMR1_ON(true);       // (re)start timer 1 (tickless mode)
     LNCON.TMR1_MODE = 2;            // 2: timer 1 in linebreak mode
 }
 
@@ -541,9 +1055,10 @@ void startSyncBrg1(void)
     // a delay in the start of the transmission may lead to a none-detection
     // whether the line is still free
     // to make this possible restart the BRG and start a delay of
-    // approximately 60s
+    // approximately 60µs
     setBrg1();
-    WRITETIMER1(~DELAY_60US);   // set delay approxity 60s (= 1 bit) in timer 1
+    LN_HAL_WRITE_TMR1(~DELAY_60US); // set delay approxity 60µs (= 1 bit) in timer 1
+    LN_HAL_SET_TMR1_ON(true);       // (re)start timer 1 (tickless mode)
     LNCON.TMR1_MODE = 3;        // 3: timer 1 mode in synchronisation BRG
 }
 
@@ -556,11 +1071,10 @@ void setBrg1(void)
     // BRG value = (64.000.000 / (64 x 16.666)) - 1 = 59 (0x3B)
     // calculated baudrate = 64.000.000 / (64 x (59 + 1)) = 1.666,666667
     // error = (1.666,666667 - 1.666) / 1.666 = 0.04 %
-    SP1BRG = 59U;
+    LN_HAL_SET_BRG(59U);
 
     // this let the BRG do the synchronisation
-    TX1STAbits.TXEN = false;
-    TX1STAbits.TXEN = true;
+    LN_HAL_RESTART_BRG();
 }
 
 // </editor-fold>
@@ -7,6 +7,21 @@
  *  v0.1 Creation (14/01/2024)
  *  v1.0 Merge PIC18F2525/2620/4525/4620 and PIC18F24/25/26/27/45/46/47Q10 microcontrollers (20/07/2024)
  *  v1.1 Remove PIC18F2525/2620/4525/4620 (obsolete processor)
+ *  v1.2 Hardware abstraction layer (ln_hal.h) and host build (16/10/2026)
+ *  v1.3 LN TX and RX queues with complete LN messages (frames) (16/10/2026)
+ *  v1.4 Deferred RX dispatch (lnPoll) (16/10/2026)
+ *  v1.5 Incremental RX length and checksum (16/10/2026)
+ *  v1.6 RX filter (opcode and address) (16/10/2026)
+ *  v1.7 Driver statistics (16/10/2026)
+ *  v1.8 LN TX priority classes (16/10/2026)
+ *  v1.9 Adaptive collision backoff (16/10/2026)
+ *  v1.10 Seed of the random generator (unique ID) (16/10/2026)
+ *  v1.11 Event-driven start of the transmission (16/10/2026)
+ *  v1.12 Tickless idle mode (16/10/2026)
+ *  v1.13 Transmit a LN message from a buffer (lnTxSend) (16/10/2026)
+ *  v1.14 TX backpressure (status and space available callback) (16/10/2026)
+ *  v1.15 Transmit a LN message with checksum (lnTxPrioritySendRaw) (16/10/2026)
+ *  v1.16 No restart of the LN message being transmitted (16/10/2026)
  */
 
 // this is a guard condition so that contents of this file are not included
@@ -16,6 +31,7 @@
 
 #include "config.h"
 #include "circular_queue.h"
+#include "ln_hal.h"
 
 // definitions
 #define LINEBREAK_LONG 1800U
@@ -24,6 +40,43 @@
 #define DELAY_60US 42U
 
 #define LN_RX_TX_LED false
+// true = the LN RX message callback is called by lnPoll (main loop)
+// false = the LN RX message callback is called in the ISR (rxHandler)
+#ifndef LN_RX_DEFERRED
+#define LN_RX_DEFERRED true
+#endif
+
+// LN TX priority classes, every class has its own LN TX queue (0 = highest)
+// and the LN messages of the highest non-empty class are transmitted first
+// every class may have an other producer (e.g. high priority ISR and main)
+#define LN_TX_PRIORITIES 2
+#define LN_TX_PRIORITY_HIGH 0       // e.g. feedback (turnout sensor reports)
+#define LN_TX_PRIORITY_NORMAL 1     // all other LN messages
+
+// adaptive backoff: the random window of the CMP delay (2^n ticks of 0.5µs)
+// grows with every collision or linebreak seen by this device and shrinks
+// with every LN message that is transmitted without errors
+// false = fixed random window of 1024µs (LN specification)
+#ifndef LN_ADAPTIVE_BACKOFF
+#define LN_ADAPTIVE_BACKOFF false
+#endif
+#ifndef LN_BACKOFF_MIN_BITS
+#define LN_BACKOFF_MIN_BITS 11U     // 2^11 ticks = 1024µs
+#endif
+#ifndef LN_BACKOFF_MAX_BITS
+#define LN_BACKOFF_MAX_BITS 14U     // 2^14 ticks = 8192µs
+#endif
+#if (LN_BACKOFF_MIN_BITS > LN_BACKOFF_MAX_BITS) || (LN_BACKOFF_MAX_BITS > 15)
+#error "LN_BACKOFF_MIN_BITS <= LN_BACKOFF_MAX_BITS <= 15"
+#endif
+
+// tickless idle mode: timer 1 is stopped when the line is idle and nothing
+// has to be transmitted (instead of an idle delay every 1000µs), the LN
+// driver wakes up with a received byte or a new LN TX message (kickLnTx)
+// false = timer 1 keeps running with the idle delay
+#ifndef LN_TICKLESS
+#define LN_TICKLESS true
+#endif
 
 // LN flag register
 typedef struct
@@ -32,11 +85,67 @@ typedef struct
                                     // 1 = running CMP delay
                                     // 2 = running linebreak
                                     // 3 = running synchronisation BRG
+        unsigned TX_ACTIVE :1;      // 1 = first LN message of the LN TX
+                                    //     queue is being transmitted
+        unsigned TX_ECHO :1;        // 1 = waiting for the echo of the
+                                    //     transmitted byte
+        unsigned RX_ADDRESSED :1;   // 1 = the address of the LN message
+                                    //     being received must be checked
+        unsigned TX_RETRY :1;       // 1 = the LN message being transmitted
+                                    //     is broken off (linebreak)
     } LNCON_t;
 LNCON_t LNCON;
 
+// LN RX filter
+// a received LN message is only put in the LN RX queue if the opcode is
+// accepted, for an addressed opcode the address in the SW1/SW2 fields
+// (A6 - A0 = SW1 bit 6 - 0, A10 - A7 = SW2 bit 3 - 0) must match as well
+typedef struct
+    {
+        uint8_t opcodes[16];        // bitmap of the accepted opcodes
+                                    // (bit number = opcode & 0x7f)
+        uint8_t addressed[16];      // bitmap of the addressed opcodes
+        uint16_t address;           // address (11 bits)
+        uint16_t mask;              // mask of the address bits to compare
+    } lnRxFilter_t;
+lnRxFilter_t lnRxFilter;
+
+// LN statistics (the counters are free running)
+typedef struct
+    {
+        uint16_t rxFrames;          // received LN messages (in LN RX queue)
+        uint16_t txFrames;          // transmitted LN messages
+        uint16_t checksumErrors;    // received LN messages with a bad checksum
+        uint16_t framingErrors;     // framing errors (linebreaks detected)
+        uint16_t collisions;        // echo of a transmitted byte is not equal
+        uint16_t retransmits;       // LN messages that are transmitted again
+    } lnStats_t;
+lnStats_t lnStats;
+
+// LN TX statistics per priority class
+// the wait of a LN message is the number of LN messages (of all classes)
+// that are transmitted between queueing and transmitting this LN message
+typedef struct
+    {
+        uint16_t sent;              // transmitted LN messages
+        uint16_t waitTotal;         // sum of the waits (free running)
+        uint8_t waitMax;            // longest wait
+    } lnTxClassStats_t;
+lnTxClassStats_t lnTxClassStats[LN_TX_PRIORITIES];
+
+// result of lnTxSend
+typedef enum
+    {
+        LN_TX_OK = 0,               // the LN message is queued
+        LN_TX_FULL,                 // no room in the LN TX queue (retry later)
+        LN_TX_INVALID               // the length of the LN message is invalid
+    } lnTxStatus_t;
+
 // LN RX message callback definition (as function pointer)
-typedef void (*lnRxMsgCallback_t)(lnQueue_t*);
+typedef void (*lnRxMsgCallback_t)(lnFrameQueue_t*);
+// LN TX space available callback definition (as function pointer)
+// the parameter is the priority class that has room again
+typedef void (*lnTxSpaceCallback_t)(uint8_t);
 
 // LN routines
 void lnInit(lnRxMsgCallback_t);
@@ -46,6 +155,16 @@ void lnInitTmr1(void);
 void lnInitIsr(void);
 void lnInitLeds(void);
 
+void lnPoll(void);
+void lnSetTxSpaceCallback(lnTxSpaceCallback_t);
+
+void lnInitRxFilter(bool);
+void lnSetRxFilter(uint8_t, bool);
+void lnSetRxFilterAddress(uint16_t, uint16_t);
+bool isRxFilterAccepted(uint8_t);
+
+void getLnStats(uint8_t, uint8_t*);
+
 void lnIsr(void);
 void lnIsrTmr1(void);
 void lnIsrRcError(void);
@@ -53,29 +172,50 @@ void lnIsrRc(void);
 
 void rxHandler(uint8_t);
 
-void lnTxMessageHandler(lnQueue_t*);
+lnTxStatus_t lnTxMessageHandler(lnQueue_t*);
+lnTxStatus_t lnTxPriorityMessageHandler(lnQueue_t*, uint8_t);
+lnTxStatus_t lnTxSend(const uint8_t*, uint8_t);
+lnTxStatus_t lnTxPrioritySend(const uint8_t*, uint8_t, uint8_t);
+lnTxStatus_t lnTxPrioritySendRaw(const uint8_t*, uint8_t, uint8_t);
+void commitLnTxMessage(uint8_t);
+bool isLnTxPending(void);
+void kickLnTx(void);
 void startLnTxMessage(void);
 void txHandler(void);
-bool isChecksumCorrect(lnQueue_t*);
 
 bool isLnFree(void);
 
 void startIdleDelay(void);
+void stopTimer1(void);
 void startCmpDelay(void);
 void startLinebreak(uint16_t);
 void startSyncBrg1(void);
 void setBrg1(void);
 
 uint16_t getRandomValue(uint16_t);
+void lnSeedRandom(uint16_t);
 
 // LN used variables
 lnRxMsgCallback_t lnRxMsgCallback;
+lnTxSpaceCallback_t lnTxSpaceCallback;
+uint8_t lnTxWaitLength[LN_TX_PRIORITIES]; // length of a rejected LN message
+                                    // (0 = no producer waits for room)
 uint8_t _;                          // dummy variable
 uint16_t lastRandomValue;           // initial value for the random generator
-lnQueue_t lnTxQueue;
-lnQueue_t lnTxTempQueue;
-lnQueue_t lnRxQueue;
-lnQueue_t lnRxTempQueue;
+uint8_t lnBackoffBits;              // random window of the CMP delay (bits)
+uint8_t lnTxIndex;                  // index of the byte to transmit
+uint8_t lnTxPriority;               // class of the LN message being transmitted
+uint8_t lnTxSequence;               // number of transmitted LN messages
+                                    // (free running, to measure the wait)
+uint8_t lnTxStamp[LN_TX_PRIORITIES][FRAME_QUEUE_SIZE]; // lnTxSequence at
+                                    // the moment a LN message is queued
+lnFrameQueue_t lnTxQueue[LN_TX_PRIORITIES];
+lnFrameQueue_t lnRxQueue;
+uint8_t lnRxLength;                 // length of the LN message being received
+                                    // (0 = no LN message being received)
+uint8_t lnRxCount;                  // number of received bytes
+uint8_t lnRxChecksum;               // running checksum (XOR) of the bytes
+uint8_t lnRxSw1;                    // SW1 field of the LN message (address)
 
 #endif	/* LN_H */
 
@@ -0,0 +1,78 @@
+/*
+ * file: ln_hal.h
+ * author: J. van Hooydonk
+ * comments: LocoNet driver, hardware abstraction layer
+ *
+ * revision history:
+ *  v1.0 Creation (16/10/2026)
+ *  v1.1 Unique ID of the device (seed of the random generator) (16/10/2026)
+ *  v1.2 Timer 1 interrupt request (TX kick) (16/10/2026)
+ *  v1.3 Start and stop of timer 1 (tickless mode) (16/10/2026)
+ *  v1.4 Region of the MUI selected (NVMCON1) (16/10/2026)
+ */
+
+// this is a guard condition so that contents of this file are not included
+// more than once
+#ifndef LN_HAL_H
+#define	LN_HAL_H
+
+#include "config.h"
+
+// the LN driver never touches the EUSART 1, timer 1 or comparator registers
+// directly in the ISR routines, but it uses the macros below
+// for the PIC18F24/25/26/27/45/46/47Q10 these macros are the register
+// accesses themselves (so there is no extra overhead), for a host build
+// (LN_HOST defined) they are mapped on the virtual-time register shim
+// refer to host/ln_hal_host.h
+
+// size (bytes) of the unique ID of the device (MUI, Microchip unique
+// identifier in the device information area)
+#define LN_HAL_MUI_SIZE 18U
+
+#ifdef LN_HOST
+
+#include "ln_hal_host.h"
+
+#else
+
+// interrupt flags
+#define LN_HAL_IS_TMR1_IF() (PIR4bits.TMR1IF)
+#define LN_HAL_CLEAR_TMR1_IF() (PIR4bits.TMR1IF = false)
+#define LN_HAL_SET_TMR1_IF() (PIR4bits.TMR1IF = true)
+#define LN_HAL_IS_RC_IF() (PIR3bits.RC1IF)
+
+// EUSART 1
+#define LN_HAL_IS_FERR() (RC1STAbits.FERR)
+#define LN_HAL_READ_RX() (RC1REG)
+#define LN_HAL_WRITE_TX(data) (TX1REG = (data))
+#define LN_HAL_SET_RX_ENABLE(value) (RC1STAbits.SPEN = (value))
+#define LN_HAL_SET_TX_PIN(value) (PORTCbits.RC6 = (value))
+#define LN_HAL_SET_BRG(value) (SP1BRG = (value))
+#define LN_HAL_RESTART_BRG() \
+    do { TX1STAbits.TXEN = false; TX1STAbits.TXEN = true; } while (0)
+
+// LN line (RC7 = output of comparator 1 and RCIDL = receiver is idle)
+#define LN_HAL_IS_LINE_IDLE() (PORTCbits.RC7 && BAUD1CONbits.RCIDL)
+
+// timer 1
+#define LN_HAL_WRITE_TMR1(value) WRITETIMER1(value)
+#define LN_HAL_SET_TMR1_ON(value) (T1CONbits.TMR1ON = (value))
+
+// leds (active high)
+#define LN_HAL_SET_LED_LN(value) (LATAbits.LATA5 = (value))
+#define LN_HAL_SET_LED_RX(value) (LATEbits.LATE0 = (value))
+#define LN_HAL_SET_LED_TX(value) (LATEbits.LATE1 = (value))
+
+// unique ID (MUI at 0x3F0000 - 0x3F0011, read with a table read)
+// the table read accesses the region selected by NVMCON1<7:6> (REG<1:0>),
+// the MUI is in the device information area (REG = 0b01), the old value of
+// NVMCON1 (e.g. data EEPROM access) is restored after the read
+#define LN_HAL_READ_MUI(index, value) \
+    do { uint8_t nvmcon1 = NVMCON1; NVMCON1 = 0x40; \
+        TBLPTRU = 0x3f; TBLPTRH = 0x00; TBLPTRL = (index); \
+        asm("TBLRD*"); (value) = TABLAT; NVMCON1 = nvmcon1; } while (0)
+
+#endif	/* LN_HOST */
+
+#endif	/* LN_HAL_H */
+